@@ -9,3 +9,7 @@ bin2c -o ultimax_memcfg.h ultimax_memcfg
 64tass --nostart ultimax_vsf.a
 xcopy /Y a.out ultimax_vsf
 bin2c -o ultimax_vsf.h ultimax_vsf
+
+64tass --nostart ultimax_freeze.a
+xcopy /Y a.out ultimax_freeze
+bin2c -o ultimax_freeze.h ultimax_freeze
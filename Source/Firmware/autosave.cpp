@@ -0,0 +1,206 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - persistent mode: background autosave of REU/GeoRAM images
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include <circle/sysconfig.h>
+#include <circle/timer.h>
+#include "helpers.h"
+#include "rad_jobs.h"
+#include "autosave.h"
+#include "lz_image.h"
+
+// switched on with "PERSISTENT ON" in rad.cfg
+u32 radPersistent = 0;
+
+AUTOSAVE autosave AAA;
+
+static CLogger *autosaveLogger;
+static const char *autosaveDrive;
+static u8 pending[ AUTOSAVE_BLOCKS_MAX ];
+static u8 stage[ AUTOSAVE_STAGE_SIZE ] AAA;
+
+// writes all blocks which have been modified since the last round, returns 0 on write errors
+static int autosaveRound( FIL *file )
+{
+	AUTOSAVE *a = &autosave;
+	u32 n = 0;
+
+	// take the dirty marks: a block modified from now on is marked again and written in the next round
+	for ( u32 i = 0; i < a->nBlocks; i++ )
+		if ( ( pending[ i ] = a->state[ i ] & a->mask ) )
+		{
+			a->state[ i ] &= ~a->mask;
+			n ++;
+		}
+
+	if ( n == 0 )
+		return 1;
+
+	// the cleared marks are visible to core 0 before the blocks are copied
+	DATA_SYNC_BARRIER
+
+	u32 blockSize = 1 << a->blockShift;
+	u32 result = FR_OK;
+
+	for ( u32 i = 0; i < a->nBlocks && result == FR_OK; )
+	{
+		if ( !pending[ i ] )
+		{
+			i ++;
+			continue;
+		}
+
+		// snapshot of a run of modified blocks
+		u32 first = i, ofs = i << a->blockShift, length = 0;
+		while ( i < a->nBlocks && pending[ i ] && length + blockSize <= AUTOSAVE_STAGE_SIZE )
+		{
+			u32 l = min( blockSize, a->size - ( i << a->blockShift ) );
+			memcpy( &stage[ length ], &a->mem[ i << a->blockShift ], l );
+			length += l;
+			i ++;
+		}
+
+		u32 nBytesWritten;
+		if ( ( result = f_lseek( file, ofs ) ) == FR_OK )
+			result = f_write( file, stage, length, &nBytesWritten );
+
+		// core 0 stores the data and the mark without a barrier, i.e. the mark may have been visible before the data:
+		// a block whose copy is torn differs from the memory after the (much slower) write and is written again
+		for ( u32 j = first; j < i; j++ )
+		{
+			u32 l = min( blockSize, a->size - ( j << a->blockShift ) );
+			if ( memcmp( &stage[ ( j - first ) << a->blockShift ], &a->mem[ j << a->blockShift ], l ) )
+				a->state[ j ] |= a->mask;
+		}
+	}
+
+	if ( result == FR_OK )
+		result = f_sync( file );
+
+	if ( result != FR_OK )
+	{
+		autosaveLogger->Write( "RAD", LogError, "Autosave: write error" );
+
+		// try again next time
+		for ( u32 i = 0; i < a->nBlocks; i++ )
+			if ( pending[ i ] )
+				a->state[ i ] |= a->mask;
+		return 0;
+	}
+
+	a->rounds ++;
+	a->blocksWritten += n;
+	return 1;
+}
+
+static void autosaveJob( void *param )
+{
+	AUTOSAVE *a = &autosave;
+
+	// mount file system
+	if ( fsMount( autosaveDrive ) != FR_OK )
+		autosaveLogger->Write( "RAD", LogPanic, "Cannot mount drive: %s", autosaveDrive );
+
+	// the file stays open while the emulation is running
+	FIL file;
+	u32 ok = 0;
+	if ( f_open( &file, a->image, FA_WRITE | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		autosaveLogger->Write( "RAD", LogNotice, "Autosave: cannot open file %s", a->image );
+	} else
+	{
+		if ( f_size( &file ) == a->size )
+		{
+			while ( !a->stop )
+			{
+				for ( u32 t = 0; t < AUTOSAVE_INTERVAL_MS && !a->stop; t += 10 )
+					CTimer::SimpleMsDelay( 10 );
+				autosaveRound( &file );
+			}
+
+			// the emulation has stopped, nothing is modified anymore
+			ok = autosaveRound( &file );
+			for ( u32 i = 0; i < a->nBlocks; i++ )
+				if ( a->state[ i ] & a->mask )
+					ok = 0;
+		} else
+			autosaveLogger->Write( "RAD", LogNotice, "Autosave: size of %s differs", a->image );
+
+		if ( f_close( &file ) != FR_OK )
+			autosaveLogger->Write( "RAD", LogPanic, "Cannot close file" );
+	}
+
+	a->complete = ok;
+}
+
+int autosaveStart( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *mem, u32 size, volatile u8 *state, u8 mask, u32 blockShift )
+{
+	AUTOSAVE *a = &autosave;
+
+	a->active = 0;
+
+#ifndef ARM_ALLOW_MULTI_CORE
+	// there is no core to run the job in parallel to the emulation
+	return 0;
+#endif
+
+	// compressed images are rewritten as a whole when saving from the menu
+	if ( !radPersistent || lzIsCompressedImage( FILENAME ) || size == 0 )
+		return 0;
+
+	autosaveLogger = logger;
+	autosaveDrive = DRIVE;
+
+	a->mem = mem;
+	a->size = size;
+	a->state = state;
+	a->mask = mask;
+	a->blockShift = blockShift;
+	a->nBlocks = min( ( size + ( 1 << blockShift ) - 1 ) >> blockShift, (u32)AUTOSAVE_BLOCKS_MAX );
+	a->rounds = a->blocksWritten = 0;
+	a->stop = a->complete = 0;
+	strncpy( a->image, FILENAME, sizeof( a->image ) - 1 );
+
+	if ( !jobPost( JOB_CORE_IO, autosaveJob, 0 ) )
+		return 0;
+
+	a->active = 1;
+	return 1;
+}
+
+int autosaveStop()
+{
+	if ( !autosave.active )
+		return 0;
+
+	autosave.stop = 1;
+	jobWait( JOB_CORE_IO );
+	autosave.active = 0;
+
+	return autosave.complete;
+}
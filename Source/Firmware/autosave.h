@@ -0,0 +1,68 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - persistent mode: background autosave of REU/GeoRAM images
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _autosave_h
+#define _autosave_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// persistent mode ("PERSISTENT ON" in rad.cfg): while the emulation is running, a job on the I/O core (see rad_jobs.h)
+// writes the modified blocks of a mounted (uncompressed) image back to its file every AUTOSAVE_INTERVAL_MS;
+// the polling loops only set the dirty marks they set anyway (reuPages.state, geoDirty), without any barrier;
+// the I/O core clears the marks, copies the blocks to a staging buffer after a barrier, and after writing them
+// marks every block again whose copy differs from the memory (e.g. data stores of core 0 which became visible late)
+#define AUTOSAVE_INTERVAL_MS	2000
+#define AUTOSAVE_BLOCKS_MAX		4096
+#define AUTOSAVE_STAGE_SIZE		( 64 * 1024 )
+
+typedef struct
+{
+	volatile u32 active, stop;
+	volatile u32 complete;		// all modified blocks are on the SD card after the last round
+
+	u8  *mem;
+	u32 size;
+	volatile u8 *state;
+	u8  mask;
+	u32 blockShift, nBlocks;
+	u32 rounds, blocksWritten;
+	char image[ 1024 ];
+} AUTOSAVE;
+
+extern u32 radPersistent;
+extern AUTOSAVE autosave;
+
+// posts the autosave job for an image which has been loaded to mem (size bytes), state[ i ] & mask marks block i modified
+extern int autosaveStart( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *mem, u32 size, volatile u8 *state, u8 mask, u32 blockShift );
+
+// ends the persistent mode after the polling loop has returned (waits for the final round),
+// returns 1 if the image file is up to date
+extern int autosaveStop();
+
+#endif
@@ -31,9 +31,17 @@
 #include "lowlevel_arm64.h"
 #include "config.h"
 #include "helpers.h"
+#include "reu_trace.h"
+#include "reu_prefetch.h"
+#include "autosave.h"
+#include "rad_reu.h"
+#include "reu_profile.h"
+#include "freeze.h"
+#include "vsf_file.h"
+#include "dircache.h"
 #include "linux/kernel.h"
 
-u32 radStartup = 0, radStartupSize = 0, radSilentMode = 0, radWaitCycles = 200000;
+u32 radStartup = 0, radStartupSize = 0, radSilentMode = 0, radWaitCycles = 200000, radImageCompression = 0;
 
 int atoi( char* str )
 {
@@ -101,6 +109,64 @@ int readConfig( CLogger *logger, const char *DRIVE, const char *FILENAME )
 					if ( strcmp( ptr, "SILENT" ) == 0 ) radSilentMode = 0xffffffff; 
 				}
 
+				if ( strcmp( ptr, "REU_TRACE" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) reuTraceEnabled = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) reuTraceEnabled = 0;
+				}
+
+				if ( strcmp( ptr, "IMAGE_COMPRESSION" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) radImageCompression = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) radImageCompression = 0;
+				}
+
+				if ( strcmp( ptr, "PERSISTENT" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) radPersistent = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) radPersistent = 0;
+				}
+
+				if ( strcmp( ptr, "DIRCACHE" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) radDirCache = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) radDirCache = 0;
+				}
+
+				if ( strcmp( ptr, "VSF_VERIFY" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) radVSFVerify = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) radVSFVerify = 0;
+				}
+
+				if ( strcmp( ptr, "FREEZE" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ON" ) == 0 ) radFreeze = 1;
+					if ( strcmp( ptr, "OFF" ) == 0 ) radFreeze = 0;
+				}
+
+				if ( strcmp( ptr, "REU_PREFETCH" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( strcmp( ptr, "ADAPTIVE" ) == 0 ) reuPrefetchAdaptive = 1;
+					if ( strcmp( ptr, "LINEAR" ) == 0 ) reuPrefetchAdaptive = 0;
+				}
+
+				// per-image setting, e.g. REU_PREFETCH_LINEAR "some demo.reu"
+				if ( strcmp( ptr, "REU_PREFETCH_ADAPTIVE" ) == 0 || strcmp( ptr, "REU_PREFETCH_LINEAR" ) == 0 )
+				{
+					u32 adaptive = strcmp( ptr, "REU_PREFETCH_ADAPTIVE" ) == 0;
+					while ( rest && ( *rest == ' ' || *rest == '\t' ) ) rest ++;
+					if ( rest && ( ptr = strtok_r( NULL, "\"", &rest ) ) )
+						reuPrefetchSetImage( ptr, adaptive );
+				}
+
 				if ( strcmp( ptr, "STARTUP" ) == 0 )
 				{
 					ptr = strtok_r( NULL, " \t", &rest );
@@ -165,6 +231,85 @@ int readConfig( CLogger *logger, const char *DRIVE, const char *FILENAME )
 	return 1;
 }
 
+static u32 atoiHex( char *str )
+{
+	u32 res = 0;
+	for ( int i = 0; str[ i ] != '\0' && str[ i ] != 10 && str[ i ] != 13; i ++ )
+	{
+		char c = str[ i ];
+		if ( c >= '0' && c <= '9' ) res = res * 16 + c - '0'; else
+		if ( c >= 'a' && c <= 'f' ) res = res * 16 + c - 'a' + 10; else
+		if ( c >= 'A' && c <= 'F' ) res = res * 16 + c - 'A' + 10;
+	}
+	return res;
+}
+
+// per-title settings, see reu_profile.h
+int readProfiles( CLogger *logger, const char *DRIVE, const char *FILENAME )
+{
+	u32 cfgBytes;
+	memset( cfg, 0, 65536 );
+
+	if ( !readFile( logger, DRIVE, FILENAME, (u8*)cfg, &cfgBytes ) )
+		return 0;
+
+	cfgPos = cfg;
+	REUPROFILE *p = NULL;
+
+	while ( *cfgPos != 0 )
+	{
+		if ( getNextLine() && curLine[ 0 ] )
+		{
+			char *rest = NULL;
+			char *ptr = strtok_r( curLine, " \t", &rest );
+
+			if ( !ptr )
+				continue;
+
+			if ( strcmp( ptr, "PROFILE" ) == 0 )
+			{
+				p = ( ptr = strtok_r( NULL, " \t", &rest ) ) ? reuProfileAdd( atoiHex( ptr ) ) : NULL;
+				continue;
+			}
+
+			// settings before the first PROFILE line (or beyond REU_PROFILES_MAX) are ignored
+			if ( !p )
+				continue;
+
+			if ( strcmp( ptr, "SPECIAL" ) == 0 )
+			{
+				while ( ( ptr = strtok_r( NULL, " \t", &rest ) ) )
+				{
+					if ( strcmp( ptr, "NUVIE" ) == 0 ) p->special |= SPECIAL_NUVIE;
+					if ( strcmp( ptr, "BLUREU" ) == 0 ) p->special |= SPECIAL_BLUREU;
+					if ( strcmp( ptr, "NO_VERIFY_HACK" ) == 0 ) p->special |= SPECIAL_NO_VERIFY_HACK;
+				}
+				continue;
+			}
+
+			if ( strcmp( ptr, "REU_PREFETCH" ) == 0 )
+			{
+				if ( ( ptr = strtok_r( NULL, " \t", &rest ) ) )
+				{
+					if ( strcmp( ptr, "ADAPTIVE" ) == 0 ) p->prefetch = 1;
+					if ( strcmp( ptr, "LINEAR" ) == 0 ) p->prefetch = 0;
+				}
+				continue;
+			}
+
+			for ( int i = 0; i < TIMING_NAMES; i++ )
+				if ( strcmp( ptr, timingNames[ i ] ) == 0 && ( ptr = strtok_r( NULL, "\"", &rest ) ) )
+				{
+					p->timing[ i ] = atoi( ptr );
+					p->timingSet |= 1 << i;
+					break;
+				}
+		}
+	}
+
+	return 1;
+}
+
 void temporaryTimingsUpdate( int *newTimingValues )
 {
 	// this value is not present in the REU emulation data structure!
@@ -28,7 +28,7 @@
 #ifndef _config_h
 #define _config_h
 
-extern u32 radStartup, radStartupSize, radSilentMode, radWaitCycles;
+extern u32 radStartup, radStartupSize, radSilentMode, radWaitCycles, radImageCompression;
 
 #define TIMING_NAMES 22
 const char timingNames[TIMING_NAMES][32] = {
@@ -57,6 +57,7 @@ const char timingNames[TIMING_NAMES][32] = {
 };
 
 extern int readConfig( CLogger *logger, const char *DRIVE, const char *FILENAME );
+extern int readProfiles( CLogger *logger, const char *DRIVE, const char *FILENAME );
 extern int changeTimingsInConfig( CLogger *logger, const char *DRIVE, const char *FILENAME, int *newTimingValues );
 
 #endif
@@ -0,0 +1,163 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - CRC-32 (ARMv8 CRC instructions or slice-by-8 tables)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "crc32.h"
+
+#define CRC32_POLY	0xedb88320
+
+u32 crc32Bitwise( u32 crc, const u8 *p, u32 n )
+{
+	while ( n -- )
+	{
+		crc ^= *( p ++ );
+		for ( u32 j = 0; j < 8; j++ )
+			crc = ( crc >> 1 ) ^ ( CRC32_POLY & ( -( crc & 1 ) ) );
+	}
+	return crc;
+}
+
+// polynomials modulo the CRC polynomial in the same bit order as the CRC (x^0 is bit 31), as in zlib's crc32_combine
+static u32 crc32MultModP( u32 a, u32 b )
+{
+	u32 m = 1u << 31, p = 0;
+	for ( ;; )
+	{
+		if ( a & m )
+		{
+			p ^= b;
+			if ( ( a & ( m - 1 ) ) == 0 )
+				break;
+		}
+		m >>= 1;
+		b = ( b >> 1 ) ^ ( CRC32_POLY & ( -( b & 1 ) ) );
+	}
+	return p;
+}
+
+// x^( 8 * n ) modulo the CRC polynomial: appending n bytes multiplies the CRC register by this
+static u32 crc32BytesModP( u32 n )
+{
+	u32 p = 1u << 31, x = 1u << 23;
+	for ( ; n; n >>= 1, x = crc32MultModP( x, x ) )
+		if ( n & 1 )
+			p = crc32MultModP( x, p );
+	return p;
+}
+
+u32 crc32Combine( u32 crcA, u32 crcB, u32 lengthB )
+{
+	return crc32MultModP( crc32BytesModP( lengthB ), crcA ) ^ crcB;
+}
+
+u32 crc32Zeros( u32 n )
+{
+	return ~crc32MultModP( crc32BytesModP( n ), 0xffffffff );
+}
+
+#ifdef __aarch64__
+
+// the Cortex-A53 implements the CRC32 instructions of ARMv8 (8 bytes per instruction)
+#include <arm_acle.h>
+
+__attribute__( ( target( "+crc" ) ) )
+u32 crc32Update( u32 crc, const u8 *p, u32 n )
+{
+	while ( n && ( (uintptr)p & 7 ) )
+	{
+		crc = __crc32b( crc, *( p ++ ) );
+		n --;
+	}
+
+	const u64 *p64 = (const u64 *)p;
+	for ( ; n >= 32; n -= 32, p64 += 4 )
+	{
+		crc = __crc32d( crc, p64[ 0 ] );
+		crc = __crc32d( crc, p64[ 1 ] );
+		crc = __crc32d( crc, p64[ 2 ] );
+		crc = __crc32d( crc, p64[ 3 ] );
+	}
+	for ( ; n >= 8; n -= 8 )
+		crc = __crc32d( crc, *( p64 ++ ) );
+
+	p = (const u8 *)p64;
+	while ( n -- )
+		crc = __crc32b( crc, *( p ++ ) );
+
+	return crc;
+}
+
+#else
+
+// slice-by-8: table[ k ][ b ] is the CRC of byte b followed by k zero bytes
+static u32 crcTable[ 8 ][ 256 ];
+static u32 crcTableReady = 0;
+
+static void crc32InitTables()
+{
+	for ( u32 b = 0; b < 256; b++ )
+	{
+		u32 c = b;
+		for ( u32 j = 0; j < 8; j++ )
+			c = ( c >> 1 ) ^ ( CRC32_POLY & ( -( c & 1 ) ) );
+		crcTable[ 0 ][ b ] = c;
+	}
+
+	for ( u32 b = 0; b < 256; b++ )
+		for ( u32 k = 1; k < 8; k++ )
+			crcTable[ k ][ b ] = ( crcTable[ k - 1 ][ b ] >> 8 ) ^ crcTable[ 0 ][ crcTable[ k - 1 ][ b ] & 255 ];
+
+	crcTableReady = 1;
+}
+
+u32 crc32Update( u32 crc, const u8 *p, u32 n )
+{
+	if ( !crcTableReady )
+		crc32InitTables();
+
+	while ( n && ( (uintptr)p & 7 ) )
+	{
+		crc = ( crc >> 8 ) ^ crcTable[ 0 ][ ( crc ^ *( p ++ ) ) & 255 ];
+		n --;
+	}
+
+	// little endian: the low word is combined with the CRC
+	for ( ; n >= 8; n -= 8, p += 8 )
+	{
+		u32 lo = *(const u32 *)p ^ crc;
+		u32 hi = *(const u32 *)( p + 4 );
+		crc = crcTable[ 7 ][ lo & 255 ] ^ crcTable[ 6 ][ ( lo >> 8 ) & 255 ] ^ crcTable[ 5 ][ ( lo >> 16 ) & 255 ] ^ crcTable[ 4 ][ lo >> 24 ] ^
+			  crcTable[ 3 ][ hi & 255 ] ^ crcTable[ 2 ][ ( hi >> 8 ) & 255 ] ^ crcTable[ 1 ][ ( hi >> 16 ) & 255 ] ^ crcTable[ 0 ][ hi >> 24 ];
+	}
+
+	while ( n -- )
+		crc = ( crc >> 8 ) ^ crcTable[ 0 ][ ( crc ^ *( p ++ ) ) & 255 ];
+
+	return crc;
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - CRC-32 (ARMv8 CRC instructions or slice-by-8 tables)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _crc32_h
+#define _crc32_h
+
+#include <circle/types.h>
+
+// CRC-32 as used by zip/PNG (reflected polynomial 0xedb88320), without the initial and final inversion:
+// crc32Update( 0xffffffff, ... ) is what the former bitwise loop in reuImageIsBlureu() computed
+extern u32 crc32Update( u32 crc, const u8 *p, u32 n );
+
+// CRC-32 (with inversions) of A followed by B, from the CRC-32 of A and B and the length of B
+extern u32 crc32Combine( u32 crcA, u32 crcB, u32 lengthB );
+
+// CRC-32 (with inversions) of n zero bytes
+extern u32 crc32Zeros( u32 n );
+
+// one bit at a time, as reference for the tests
+extern u32 crc32Bitwise( u32 crc, const u8 *p, u32 n );
+
+#endif
@@ -0,0 +1,300 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - cache of the menu browser's directory levels on the SD card
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include <stdio.h>
+#include "helpers.h"
+#include "lowlevel_arm64.h"
+#include "crc32.h"
+#include "dircache.h"
+
+u32 radDirCache = 1;
+
+typedef struct
+{
+	DIRCACHEHEADER h;
+	DIRCACHEDIR dirs[ DIRCACHE_DIRS ];
+	DIRCACHEENTRY entries[ DIRCACHE_ENTRIES ];
+	char chars[ DIRCACHE_CHARS ];
+	u32 loaded, modified;
+} DIRCACHEROOT;
+
+// only the cache of the selected root is in memory
+static DIRCACHEROOT dcRoot;
+static DIRCACHEROOT *dc = &dcRoot;
+static u32 dcRootIdx = 0;
+
+// live entries and the number of live entries before every 32 entries (see dirCacheCompact)
+static u32 dcLive[ DIRCACHE_ENTRIES / 32 ], dcRank[ DIRCACHE_ENTRIES / 32 ];
+
+static u32 dcLevelsCached, dcLevelsScanned;
+
+// FAT file names are not case sensitive
+static u32 dirCachePathHash( const char *sDir )
+{
+	u32 crc = 0xffffffff;
+	for ( const char *c = sDir; *c; c++ )
+	{
+		u8 ch = ( *c >= 'a' && *c <= 'z' ) ? *c - 'a' + 'A' : *c;
+		crc = crc32Update( crc, &ch, 1 );
+	}
+	return ~crc;
+}
+
+static u32 dirCacheRead( FIL *file, void *p, u32 n )
+{
+	u32 nBytesRead = 0;
+	return f_read( file, p, n, &nBytesRead ) == FR_OK && nBytesRead == n;
+}
+
+// the file is read straight into the cache, the header is only taken over if all parts have been read
+static void dirCacheLoad()
+{
+	FIL file;
+	DIRCACHEHEADER h;
+	char filename[ 64 ];
+
+	dc->loaded = 1;
+	dc->modified = 0;
+	memset( &dc->h, 0, sizeof( DIRCACHEHEADER ) );
+
+	sprintf( filename, DIRCACHE_FILE, dcRootIdx );
+	if ( f_open( &file, filename, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+		return;
+
+	if ( dirCacheRead( &file, &h, sizeof( DIRCACHEHEADER ) ) && h.magic == DIRCACHE_MAGIC &&
+		 h.nDirs <= DIRCACHE_DIRS && h.nEntries <= DIRCACHE_ENTRIES && h.nChars <= DIRCACHE_CHARS &&
+		 f_size( &file ) == sizeof( DIRCACHEHEADER ) + h.nDirs * sizeof( DIRCACHEDIR ) + h.nEntries * sizeof( DIRCACHEENTRY ) + h.nChars &&
+		 dirCacheRead( &file, dc->dirs, h.nDirs * sizeof( DIRCACHEDIR ) ) &&
+		 dirCacheRead( &file, dc->entries, h.nEntries * sizeof( DIRCACHEENTRY ) ) &&
+		 dirCacheRead( &file, dc->chars, h.nChars ) )
+		dc->h = h;
+
+	f_close( &file );
+}
+
+// removes the entries of levels which have been replaced, in place: entries and their names are appended together,
+// hence moving the live ones down in this order never overwrites one which has not been moved yet
+static void dirCacheCompact()
+{
+	u32 nDirs = 0, nEntries = 0, nChars = 0;
+
+	memset( dcLive, 0, sizeof( dcLive ) );
+	for ( u32 i = 0; i < dc->h.nDirs; i++ )
+	{
+		DIRCACHEDIR *c = &dc->dirs[ i ];
+		if ( c->first + c->count > dc->h.nEntries )
+			continue;
+		for ( u32 j = c->first; j < c->first + c->count; j++ )
+			dcLive[ j >> 5 ] |= 1 << ( j & 31 );
+	}
+
+	for ( u32 j = 0; j < dc->h.nEntries; j++ )
+	{
+		if ( ( j & 31 ) == 0 )
+			dcRank[ j >> 5 ] = nEntries;
+
+		if ( !( dcLive[ j >> 5 ] & ( 1 << ( j & 31 ) ) ) )
+			continue;
+
+		DIRCACHEENTRY e = dc->entries[ j ];
+		const char *name = &dc->chars[ e.filename ];
+		u32 l = strlen( name ) + 1;
+		memmove( &dc->chars[ nChars ], name, l );
+		e.filename = nChars;
+		nChars += l;
+		dc->entries[ nEntries ++ ] = e;
+	}
+
+	// the first entry of a level is live, its new index is the number of live entries before it
+	for ( u32 i = 0; i < dc->h.nDirs; i++ )
+	{
+		DIRCACHEDIR c = dc->dirs[ i ];
+		if ( c.first + c.count > dc->h.nEntries )
+			continue;
+		if ( c.count == 0 )
+			c.first = 0; else
+			c.first = dcRank[ c.first >> 5 ] + __builtin_popcount( dcLive[ c.first >> 5 ] & ( ( 1u << ( c.first & 31 ) ) - 1 ) );
+		dc->dirs[ nDirs ++ ] = c;
+	}
+
+	dc->h.nDirs = nDirs;
+	dc->h.nEntries = nEntries;
+	dc->h.nChars = nChars;
+}
+
+void dirCacheSelect( u32 root )
+{
+	dcLevelsCached = dcLevelsScanned = 0;
+
+	// every selection ends with dirCacheFlush, i.e. the cache of the previous root is on the SD card
+	if ( root != dcRootIdx )
+	{
+		dcRootIdx = root;
+		dc->loaded = 0;
+	}
+
+	if ( radDirCache && !dc->loaded )
+		dirCacheLoad();
+}
+
+void dirCacheFlush( CLogger *logger )
+{
+	FIL file;
+	u32 nBytesWritten;
+	char filename[ 64 ];
+
+	if ( !radDirCache || !dc->modified )
+		return;
+
+	logger->Write( "RAD", LogNotice, "directory cache %d: %d levels unchanged, %d rescanned", dcRootIdx, dcLevelsCached, dcLevelsScanned );
+
+	dirCacheCompact();
+	dc->modified = 0;
+
+	sprintf( filename, DIRCACHE_FILE, dcRootIdx );
+	if ( f_open( &file, filename, FA_WRITE | FA_CREATE_ALWAYS ) != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot write file: %s", filename );
+		return;
+	}
+
+	dc->h.magic = DIRCACHE_MAGIC;
+	f_write( &file, &dc->h, sizeof( DIRCACHEHEADER ), &nBytesWritten );
+	f_write( &file, dc->dirs, dc->h.nDirs * sizeof( DIRCACHEDIR ), &nBytesWritten );
+	f_write( &file, dc->entries, dc->h.nEntries * sizeof( DIRCACHEENTRY ), &nBytesWritten );
+	f_write( &file, dc->chars, dc->h.nChars, &nBytesWritten );
+	f_close( &file );
+}
+
+u32 dirCacheSignature( const char *sDir, u32 *nFiles, u32 *signature )
+{
+	DIR dir;
+	FILINFO info;
+
+	if ( f_opendir( &dir, sDir ) != FR_OK )
+		return 0;
+
+	u32 crc = 0xffffffff;
+	*nFiles = 0;
+
+	while ( f_readdir( &dir, &info ) == FR_OK && info.fname[ 0 ] )
+	{
+		u32 attr[ 4 ] = { (u32)info.fsize, info.fdate, info.ftime, info.fattrib };
+		crc = crc32Update( crc, (const u8*)info.fname, strlen( info.fname ) );
+		crc = crc32Update( crc, (const u8*)attr, sizeof( attr ) );
+		( *nFiles ) ++;
+	}
+
+	f_closedir( &dir );
+
+	*signature = ~crc;
+	return 1;
+}
+
+static DIRCACHEDIR *dirCacheFind( u32 pathHash )
+{
+	for ( u32 i = 0; i < dc->h.nDirs; i++ )
+		if ( dc->dirs[ i ].pathHash == pathHash )
+			return &dc->dirs[ i ];
+	return NULL;
+}
+
+u32 dirCacheLookup( const char *sDir, u32 dir, u32 nFiles, u32 signature, REUDIRENTRY *d )
+{
+	DIRCACHEDIR *c = dirCacheFind( dirCachePathHash( sDir ) );
+
+	if ( !c || c->nFiles != nFiles || c->signature != signature || c->first + c->count > dc->h.nEntries )
+	{
+		dcLevelsScanned ++;
+		return 0;
+	}
+
+	for ( u32 j = 0; j < c->count; j++ )
+	{
+		DIRCACHEENTRY *e = &dc->entries[ c->first + j ];
+		if ( e->filename >= dc->h.nChars )
+			return 0;
+
+		d[ j ].dir = dir;
+		d[ j ].filename = dirArenaAdd( &dc->chars[ e->filename ] );
+		d[ j ].f = e->f;
+		d[ j ].size = e->size;
+		d[ j ].fileOp = 0;
+		d[ j ].rename = 0;
+	}
+
+	dcLevelsCached ++;
+	return c->count;
+}
+
+static u32 dirCacheFits( u32 n, u32 nChars )
+{
+	return dc->h.nDirs < DIRCACHE_DIRS && dc->h.nEntries + n <= DIRCACHE_ENTRIES && dc->h.nChars + nChars <= DIRCACHE_CHARS;
+}
+
+void dirCacheStore( const char *sDir, u32 nFiles, u32 signature, const REUDIRENTRY *d, u32 n )
+{
+	u32 nChars = 0;
+	for ( u32 j = 0; j < n; j++ )
+		nChars += strlen( DIRENTRY_FILENAME( &d[ j ] ) ) + 1;
+
+	// make room, or start over if the cache is full of directories which do not exist anymore
+	if ( !dirCacheFits( n, nChars ) )
+		dirCacheCompact();
+	if ( !dirCacheFits( n, nChars ) )
+		memset( &dc->h, 0, sizeof( DIRCACHEHEADER ) );
+	if ( !dirCacheFits( n, nChars ) )
+		return;
+
+	u32 pathHash = dirCachePathHash( sDir );
+	DIRCACHEDIR *c = dirCacheFind( pathHash );
+	if ( !c )
+		c = &dc->dirs[ dc->h.nDirs ++ ];
+
+	c->pathHash = pathHash;
+	c->nFiles = nFiles;
+	c->signature = signature;
+	c->first = dc->h.nEntries;
+	c->count = n;
+
+	for ( u32 j = 0; j < n; j++ )
+	{
+		const char *name = DIRENTRY_FILENAME( &d[ j ] );
+		u32 l = strlen( name ) + 1;
+
+		DIRCACHEENTRY *e = &dc->entries[ dc->h.nEntries ++ ];
+		e->f = d[ j ].f & ~(u32)( DIR_FILE_MARKED | REUDIR_MARKSYNC | REUDIR_UNSCANNED );
+		e->size = d[ j ].size;
+		e->filename = dc->h.nChars;
+		memcpy( &dc->chars[ dc->h.nChars ], name, l );
+		dc->h.nChars += l;
+	}
+
+	dc->modified = 1;
+}
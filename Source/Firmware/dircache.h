@@ -0,0 +1,81 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - cache of the menu browser's directory levels on the SD card
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _dircache_h
+#define _dircache_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "dirscan.h"
+
+// the menu browser keeps one file per scanned root (RAD_PRG, REU, GEORAM) with the sorted and classified entries of
+// every directory level, together with a signature of the directory: the number of entries and a hash of their names,
+// sizes and time stamps. FAT does not update the time stamp of a directory when files are added or removed, hence the
+// signature is computed from the directory entries themselves -- a level is only rescanned (file types, uncompressed
+// sizes of .reuz/.georamz, sorting) if its signature has changed
+#define DIRCACHE_FILE			"SD:RAD/dircache%d.bin"
+#define DIRCACHE_MAGIC			0x43444152		// "RADC"
+// a root can be as large as filesAll and the name arena (every directory is an entry of its parent)
+#define DIRCACHE_DIRS			MAX_DIR_ENTRIES
+#define DIRCACHE_ENTRIES		MAX_DIR_ENTRIES
+#define DIRCACHE_CHARS			DIR_ARENA_SIZE
+
+typedef struct
+{
+	u32 magic, nDirs, nEntries, nChars;
+} DIRCACHEHEADER;
+
+typedef struct
+{
+	u32 pathHash, nFiles, signature;
+	u32 first, count;
+} DIRCACHEDIR;
+
+typedef struct
+{
+	u32 f, size, filename;
+} DIRCACHEENTRY;
+
+extern u32 radDirCache;
+
+// the levels are only scanned when a directory is entered (see expandDirectory), so the cache of the selected root stays
+// in memory (the roots share one cache): its file is read when another root is selected, changed levels replace their
+// old entries and dirCacheFlush writes the file (without the replaced entries) if anything has been rescanned
+extern void dirCacheSelect( u32 root );
+extern void dirCacheFlush( CLogger *logger );
+
+// computes the signature of the directory sDir, returns 0 if it cannot be read (the file system must be mounted)
+extern u32 dirCacheSignature( const char *sDir, u32 *nFiles, u32 *signature );
+
+// returns the number of entries of the level sDir if it is cached with this signature and copies them to d (as entries of dir)
+extern u32 dirCacheLookup( const char *sDir, u32 dir, u32 nFiles, u32 signature, REUDIRENTRY *d );
+
+// adds the (sorted) entries of the level sDir to the new cache file
+extern void dirCacheStore( const char *sDir, u32 nFiles, u32 signature, const REUDIRENTRY *d, u32 n );
+
+#endif
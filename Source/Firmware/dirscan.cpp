@@ -34,6 +34,9 @@
 #include <stdio.h>
 
 #include "rad_iecdevice.h"
+#include "lz_image.h"
+#include "dircache.h"
+#include "dirsearch.h"
 
 extern CLogger *logger;
 
@@ -61,7 +64,7 @@ int compareEntriesREU( const void *e1, const void *e2 )
 	if ( (a->f & REUDIR_DUMMYNEW) ) return -1;
 	if ( (b->f & REUDIR_DUMMYNEW) ) return 1;
 
-	return strcasecmp( (char*)a->filename, (char*)b->filename );
+	return strcasecmp( DIRENTRY_FILENAME( a ), DIRENTRY_FILENAME( b ) );
 }
 
 void quicksortREU( REUDIRENTRY *begin, REUDIRENTRY *end )
@@ -81,12 +84,43 @@ void quicksortREU( REUDIRENTRY *begin, REUDIRENTRY *end )
 
 
 REUDIRENTRY sort[ 2048 ];
+REUDIRENTRY filesAll[ MAX_DIR_ENTRIES ];
 
-void makeFormattedName( REUDIRENTRY *d )
+char dirArena[ DIR_ARENA_SIZE ];
+static u32 dirArenaUsed = 1;
+
+u32 dirArenaAdd( const char *s )
+{
+	u32 l = strlen( s ) + 1;
+	if ( dirArenaUsed + l > DIR_ARENA_SIZE )
+		return 0;
+
+	u32 ofs = dirArenaUsed;
+	memcpy( &dirArena[ ofs ], s, l );
+	dirArenaUsed += l;
+	return ofs;
+}
+
+char *dirEntryPath( const REUDIRENTRY *e, char *path )
+{
+	if ( e->dir & REUDIR_ROOT )
+	{
+		strcpy( path, &dirArena[ e->dir & ~REUDIR_ROOT ] );
+	} else
+	{
+		const REUDIRENTRY *d = &filesAll[ e->dir ];
+		dirEntryPath( d, path );
+		strcat( path, "\\" );
+		strcat( path, DIRENTRY_FILENAME( d ) );
+	}
+	return path;
+}
+
+void makeFormattedName( const REUDIRENTRY *d, char *formatted )
 {
 	char filename[ 1024 ], fn_up[ 1024 ];
 	memset( filename, 0, 1024 );
-	strncpy( filename, (char*)d->filename, 1023 );
+	strncpy( filename, DIRENTRY_FILENAME( d ), 1023 );
 	int i = 0;
 	while ( i < 1024 && filename[ i ] != 0 )
 	{
@@ -95,12 +129,16 @@ void makeFormattedName( REUDIRENTRY *d )
 	}
 	fn_up[ i ] = 0;
 
+	if ( strstr( (char*)fn_up, ".REUZ" ) )
+		filename[ strlen( filename ) - 5 ] = 0; else
 	if ( /*strstr( (char*)fn_up, ".D64" ) || */
 		 strstr( (char*)fn_up, ".PRG" ) || 
 		 strstr( (char*)fn_up, ".REU" ) )
 		filename[ strlen( filename ) - 4 ] = 0;
 	if ( strstr( (char*)fn_up, ".VSF" ) )
 		filename[ strlen( filename ) - 4 ] = 0;
+	if ( strstr( (char*)fn_up, ".GEORAMZ" ) )
+		filename[ strlen( filename ) - 8 ] = 0; else
 	if ( strstr( (char*)fn_up, ".GEORAM" ) )
 		filename[ strlen( filename ) - 7 ] = 0;
 
@@ -135,25 +173,24 @@ void makeFormattedName( REUDIRENTRY *d )
 	}
 
 
-	sprintf( (char*)d->name, "%s%s", name, fs );
+	sprintf( formatted, "%s%s", name, fs );
 }
 
-bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElementsThisLevel, u32 parent, u32 level, bool addNewImageEntry )
+// reads, classifies and sorts the entries of one directory level into sort[], returns their number
+static u32 readDirectoryLevel( const char *sDir, u32 dir, u32 level, bool addNewImageEntry )
 {
 	char sPath[ 2048 ];
 
 	u32 sortCur = 0;
 
-	nFileOpsPending = 0;
-
 	sprintf( sPath, "%s", sDir );
 
 	int nAdditionalEntries = 0;
 
 	if ( level > 0 )
 	{
-		sprintf( (char*)sort[ sortCur ].path, "%s", sDir );
-		sprintf( (char*)sort[ sortCur ].filename, ".. " );
+		sort[ sortCur ].dir = dir;
+		sort[ sortCur ].filename = dirArenaAdd( ".. " );
 		sort[ sortCur ].f = REUDIR_TOPARENT;
 		sort[ sortCur ].size = 0;
 		sortCur ++;
@@ -162,18 +199,18 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 
 	if ( addNewImageEntry )
 	{
-		sprintf( (char*)sort[ sortCur ].path, "%s", sDir );
-		sprintf( (char*)sort[ sortCur ].filename, "__NEW IMAGE__" );
+		sort[ sortCur ].dir = dir;
+		sort[ sortCur ].filename = dirArenaAdd( "__NEW IMAGE__" );
 		sort[ sortCur ].f = REUDIR_DUMMYNEW;
 		sort[ sortCur ].size = 0;
 		sortCur ++;
 		nAdditionalEntries ++;
 	}
 
-	DIR dir;
+	DIR findDir;
 	FILINFO FileInfo;
 
-	FRESULT res = f_findfirst( &dir, &FileInfo, sPath, "*" );
+	FRESULT res = f_findfirst( &findDir, &FileInfo, sPath, "*" );
 
 	if ( res != FR_OK )
 		logger->Write( "read directory", LogNotice, "error opening dir" );
@@ -185,46 +222,51 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 		{
 			sprintf( sPath, "%s\\%s", sDir, FileInfo.fname );
 
-			sort[ sortCur ].rename[ 0 ] = 0;
+			sort[ sortCur ].rename = 0;
 			sort[ sortCur ].fileOp = 0;
 			
 			// file or folder?
 			if ( ( FileInfo.fattrib & ( AM_DIR ) ) )
 			{
-				strcpy( (char*)sort[sortCur].path, sDir );
-				strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+				sort[ sortCur ].dir = dir;
+				sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 				sort[ sortCur++ ].f = REUDIR_DIRECTORY;
 				nAdditionalEntries ++;
 			} else
 			{
 				if ( strstr( FileInfo.fname, ".reu" ) > 0 || strstr( FileInfo.fname, ".REU" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
+					// .reuz: show (and select the REU size by) the uncompressed size
+					if ( lzIsCompressedImage( FileInfo.fname ) )
+						getFileSizeLZ( sPath, &sort[ sortCur ].size );
 					sort[ sortCur++ ].f = REUDIR_REUIMAGE;
 					nAdditionalEntries ++;
 				}
 				if ( strstr( FileInfo.fname, ".vsf" ) > 0 || strstr( FileInfo.fname, ".VSF" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
 					sort[ sortCur++ ].f = REUDIR_VSFIMAGE;
 					nAdditionalEntries ++;
 				}
 				if ( strstr( FileInfo.fname, ".georam" ) > 0 || strstr( FileInfo.fname, ".GEORAM" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
+					if ( lzIsCompressedImage( FileInfo.fname ) )
+						getFileSizeLZ( sPath, &sort[ sortCur ].size );
 					sort[ sortCur++ ].f = REUDIR_GEOIMAGE;
 					nAdditionalEntries ++;
 				}
 				if ( strstr( FileInfo.fname, ".prg" ) > 0 || strstr( FileInfo.fname, ".PRG" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
 					sort[ sortCur++ ].f = REUDIR_PRG;
 					nAdditionalEntries ++;
@@ -232,8 +274,8 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 
 				if ( strstr( FileInfo.fname, ".seq" ) > 0 || strstr( FileInfo.fname, ".SEQ" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
 					sort[ sortCur++ ].f = REUDIR_SEQ;
 					nAdditionalEntries ++;
@@ -246,8 +288,8 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 					 strstr( FileInfo.fname, ".g64" ) > 0 || strstr( FileInfo.fname, ".G64" ) > 0 ||
 					 strstr( FileInfo.fname, ".g71" ) > 0 || strstr( FileInfo.fname, ".G71" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
 					sort[ sortCur++ ].f = REUDIR_D64;
 					nAdditionalEntries ++;
@@ -255,8 +297,8 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 
 				if ( strstr( FileInfo.fname, ".zip" ) > 0 || strstr( FileInfo.fname, ".ZIP" ) > 0 )
 				{
-					strcpy( (char*)sort[sortCur].path, sDir );
-					strcpy( (char*)sort[sortCur].filename, FileInfo.fname );
+					sort[ sortCur ].dir = dir;
+					sort[ sortCur ].filename = dirArenaAdd( FileInfo.fname );
 					sort[ sortCur ].size = FileInfo.fsize;
 					sort[ sortCur++ ].f = REUDIR_ZIP;
 					nAdditionalEntries ++;
@@ -264,15 +306,45 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 			}
 		}
 
-		res = f_findnext( &dir, &FileInfo );
+		res = f_findnext( &findDir, &FileInfo );
 	};
 
-	f_closedir( &dir );
+	f_closedir( &findDir );
+
+	if ( nAdditionalEntries )
+		quicksortREU( &sort[ 0 ], &sort[ sortCur - 1 ] );
+
+	return nAdditionalEntries;
+}
+
+// adds the entries of the directory level sDir to d, subdirectories are scanned when they are entered (expandDirectory)
+bool ListDirectoryContents( const char *sDir, u32 dir, REUDIRENTRY *d, u32 *n, u32 *nElementsThisLevel, u32 parent, u32 level, bool addNewImageEntry )
+{
+	// unchanged directory levels are taken from the cache file
+	u32 nFiles, signature, nAdditionalEntries = 0, scanned = 0;
+	u32 validSignature = radDirCache && dirCacheSignature( sDir, &nFiles, &signature );
+
+	if ( validSignature )
+		nAdditionalEntries = dirCacheLookup( sDir, dir, nFiles, signature, sort );
+
+	if ( !nAdditionalEntries )
+	{
+		nAdditionalEntries = readDirectoryLevel( sDir, dir, level, addNewImageEntry );
+		scanned = 1;
+	}
 
 	if ( !nAdditionalEntries )
 		return true;
 
-	quicksortREU( &sort[ 0 ], &sort[ sortCur - 1 ] );
+	if ( ( d - filesAll ) + *n + nAdditionalEntries > MAX_DIR_ENTRIES )
+	{
+		logger->Write( "RaspiMenu", LogNotice, "too many files, skipping %s", sDir );
+		return false;
+	}
+
+	// only a rescanned level changes the cache (and makes dirCacheFlush write it)
+	if ( validSignature && scanned )
+		dirCacheStore( sDir, nFiles, signature, sort, nAdditionalEntries );
 
 	*nElementsThisLevel = nAdditionalEntries;
 
@@ -281,23 +353,14 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 	int prevOffset = *n;
 	*n += nAdditionalEntries;
 
-	for ( int idx = 0; idx < nAdditionalEntries; idx++ )
+	for ( u32 idx = 0; idx < nAdditionalEntries; idx++ )
 	{
 		int i = prevOffset + idx;
 		d[ i ].parent = parent;
 		d[ i ].first = d[ i ].last = 0;
 
-		makeFormattedName( &d[ i ] );
-		
 		if ( d[ i ].f & REUDIR_DIRECTORY )
-		{
-			char path[ 1024 ];
-			sprintf( path, "%s\\%s", d[ i ].path, d[ i ].filename );
-			d[ i ].first = *n;
-			u32 nElementsThisLevel;
-			ListDirectoryContents( path, d, n, &nElementsThisLevel, *n, level + 1, addNewImageEntry );
-			d[ i ].last = d[ i ].first + nElementsThisLevel - 1;
-		}
+			d[ i ].f |= REUDIR_UNSCANNED;
 	}
 
 	return true;
@@ -305,9 +368,6 @@ bool ListDirectoryContents( const char *sDir, REUDIRENTRY *d, u32 *n, u32 *nElem
 
 
 
-
-REUDIRENTRY filesAll[ 8192 ];
-
 struct BROWSESTATE
 {
 	int first, last, curPos, scrollPos;
@@ -356,89 +416,314 @@ char dirSelectedFilePRG[ 1024 ];
 char dirSelectedFileREU[ 1024 ];
 char dirSelectedFileGEO[ 1024 ];
 
+static u32 categoryRoot[ BROWSER_NUM_CATEGORIES ];
+
+int dirEntryCategory( const REUDIRENTRY *e )
+{
+	while ( !( e->dir & REUDIR_ROOT ) )
+		e = &filesAll[ e->dir ];
+
+	for ( int c = 0; c < BROWSER_NUM_CATEGORIES; c++ )
+		if ( e->dir == categoryRoot[ c ] )
+			return c;
+
+	return -1;
+}
+
+// scans the level of directory entry e of category cat, the entries are appended to filesAll
+static void scanDirectoryLevel( int cat, REUDIRENTRY *e )
+{
+	e->f &= ~REUDIR_UNSCANNED;
+
+	char path[ 1024 ];
+	dirEntryPath( e, path );
+	strcat( path, "\\" );
+	strcat( path, DIRENTRY_FILENAME( e ) );
+
+	REUDIRENTRY *d = filePtrCat[ cat ];
+	u32 n = nFilesAllCategories - ( d - filesAll ), nElementsThisLevel = 0;
+
+	e->first = n;
+	ListDirectoryContents( path, (u32)( e - filesAll ), d, &n, &nElementsThisLevel, n, 1, false );
+	e->last = e->first + nElementsThisLevel - 1;
+
+	nFilesAllCategories = ( d - filesAll ) + n;
+}
+
+// scans the level of directory entry e of category cat when it is entered for the first time, returns true if the
+// directory can be entered
+static bool expandDirectory( int cat, REUDIRENTRY *e )
+{
+	if ( !( e->f & REUDIR_UNSCANNED ) )
+		return e->last > e->first;
+
+	if ( fsMount( "SD:" ) != FR_OK )
+		return false;
+
+	dirCacheSelect( cat );
+	scanDirectoryLevel( cat, e );
+	dirCacheFlush( logger );
+
+	if ( IECDevicePresent )
+		markSyncFilesRAD();
+
+	return e->last > e->first;
+}
+
+static void expandTree( int cat, u32 first, u32 last )
+{
+	for ( u32 i = first; i < last; i++ )
+	{
+		REUDIRENTRY *e = &filePtrCat[ cat ][ i ];
+		if ( !( e->f & REUDIR_DIRECTORY ) )
+			continue;
+
+		if ( e->f & REUDIR_UNSCANNED )
+			scanDirectoryLevel( cat, e );
+
+		if ( e->last > e->first )
+			expandTree( cat, e->first, e->last + 1 );
+	}
+}
+
+// scans all directory levels which have not been entered yet (most of them are taken from the directory cache)
+static void expandAllDirectories()
+{
+	if ( fsMount( "SD:" ) != FR_OK )
+		return;
+
+	for ( int c = 0; c < BROWSER_NUM_CATEGORIES; c++ )
+	{
+		dirCacheSelect( c );
+		expandTree( c, 0, nTotalElements[ c ] );
+		dirCacheFlush( logger );
+	}
+
+	if ( IECDevicePresent )
+		markSyncFilesRAD();
+}
+
+// true if directory entry e is part of the path of file
+static bool isOnPath( const REUDIRENTRY *e, const char *file )
+{
+	char path[ 1024 ];
+	dirEntryPath( e, path );
+	strcat( path, "\\" );
+	strcat( path, DIRENTRY_FILENAME( e ) );
+
+	u32 l = strlen( path );
+	return strncmp( path, file, l ) == 0 && ( file[ l ] == '/' || file[ l ] == '\\' );
+}
+
+// after a rescan, the directories which were open are entered again: their levels are at different indices now
+static void restoreOpenDirectories( int cat )
+{
+	int shift = 0;
+
+	for ( int l = 1; l <= curLevelCat[ cat ]; l++ )
+	{
+		BROWSESTATE *b = &dirFirstLastCat[ cat ][ l ];
+		int parentPos = b->curPos + shift;
+		REUDIRENTRY *e = &filePtrCat[ cat ][ parentPos ];
+
+		if ( !( e->f & REUDIR_DIRECTORY ) || !expandDirectory( cat, e ) )
+		{
+			curLevelCat[ cat ] = l - 1;
+			curPositionCat[ cat ] = parentPos;
+			return;
+		}
+
+		shift = e->first - b->first;
+		b->curPos = parentPos;
+		b->first = e->first;
+		b->last = e->last + 1;
+	}
+
+	int level = curLevelCat[ cat ];
+	curPositionCat[ cat ] = max( dirFirstLastCat[ cat ][ level ].first, min( curPositionCat[ cat ] + shift, dirFirstLastCat[ cat ][ level ].last - 1 ) );
+}
+
+static void scrollTo( int level, int pos )
+{
+	BROWSESTATE *b = &dirFirstLast[ level ];
+	if ( pos < b->first + b->scrollPos )
+		b->scrollPos = pos - b->first;
+	if ( pos >= b->first + b->scrollPos + BROWSER_NUM_LINES )
+		b->scrollPos = pos - b->first - BROWSER_NUM_LINES + 1;
+}
+
+// moves the cursor of category cat to filesAll[ idx ], entering all directories on its path
+static void showEntry( int cat, u32 idx )
+{
+	u32 path[ 32 ];
+	int depth = 0;
+
+	for ( u32 d = filesAll[ idx ].dir; !( d & REUDIR_ROOT ) && depth < 31; d = filesAll[ d ].dir )
+		path[ depth ++ ] = d;
+
+	curCategory = cat;
+	LOAD_CATEGORY( curCategory );
+
+	int base = files - filesAll;
+
+	curLevel = 0;
+	dirFirstLast[ 0 ].first = 0;
+	dirFirstLast[ 0 ].last = nTotalElements[ cat ];
+
+	while ( depth-- > 0 )
+	{
+		REUDIRENTRY *e = &filesAll[ path[ depth ] ];
+		scrollTo( curLevel, path[ depth ] - base );
+
+		curLevel ++;
+		dirFirstLast[ curLevel ].first  = e->first;
+		dirFirstLast[ curLevel ].last   = e->last + 1;
+		dirFirstLast[ curLevel ].curPos = path[ depth ] - base;
+		dirFirstLast[ curLevel ].scrollPos = 0;
+	}
+
+	curPosition = idx - base;
+	scrollTo( curLevel, curPosition );
+
+	SAVE_CATEGORY( curCategory );
+}
+
+// walks down the directories on the path of search (only these levels need to be scanned)
 int findFile( u8 cat, char *search )
 {
 	if ( search[ 0 ] == 0 )
 		return -1;
 
 	curCategory = cat;
-
-	// start with last file in root directory
 	LOAD_CATEGORY( curCategory );
 
-	curPosition = dirFirstLast[ curLevel ].first;
-	int prevPos;
-	do {
-		prevPos = curPosition;
-		if ( curPosition < dirFirstLast[ curLevel ].last - 1 )
-			if ( ++ curPosition >= dirFirstLast[ curLevel ].first + dirFirstLast[ curLevel ].scrollPos + BROWSER_NUM_LINES )
-				dirFirstLast[ curLevel ].scrollPos ++;
-	} while ( curPosition != prevPos );
-
-	while ( true )
-	{
-		REUDIRENTRY *e = &files[ curPosition ];
+	const char *filename = strrchr( search, '/' );
+	if ( !filename )
+		return -1;
+	filename ++;
 
-		if ( files[ curPosition ].f & REUDIR_TOPARENT )
-		{
-			if ( curLevel == 0 )
-				return -1;
+	u32 first = 0, last = nTotalElements[ cat ];
 
-			// go directory up
-			curPosition = dirFirstLast[ curLevel-- ].curPos;
-			
-			if ( curPosition > dirFirstLast[ curLevel ].first )
-				curPosition --; else
-				return -1; // this was the last file
-		} else
-		if ( ( e->f & REUDIR_DIRECTORY ) && ( e->last > e->first ) )
-		{
-			// go into directory
-			curLevel ++;
-			dirFirstLast[ curLevel ].first  = e->first;
-			dirFirstLast[ curLevel ].last   = e->last + 1;
-			dirFirstLast[ curLevel ].curPos = curPosition;
+	for ( u32 i = first; i < last; i++ )
+	{
+		REUDIRENTRY *e = &files[ i ];
 
-			curPosition = e->first;
-			int prevPos;
-			do {
-				prevPos = curPosition;
-				if ( curPosition < dirFirstLast[ curLevel ].last - 1 )
-					if ( ++ curPosition >= dirFirstLast[ curLevel ].first + dirFirstLast[ curLevel ].scrollPos + BROWSER_NUM_LINES )
-						dirFirstLast[ curLevel ].scrollPos ++;
-			} while ( curPosition != prevPos );
+		if ( e->f & ( REUDIR_TOPARENT | REUDIR_DUMMYNEW ) )
+			continue;
 
-		} else
+		if ( strcmp( DIRENTRY_FILENAME( e ), filename ) == 0 )
 		{
-			char tmp[ 1024 ];
-			sprintf( tmp, "%s/%s", (const char*)e->path, (const char*)e->filename );
-
-			if ( strcmp( tmp, search ) == 0 )
+			char path[ 1024 ];
+			dirEntryPath( e, path );
+			if ( strlen( path ) == (u32)( filename - 1 - search ) && strncmp( path, search, filename - 1 - search ) == 0 )
 			{
-				SAVE_CATEGORY( curCategory );
+				showEntry( cat, e - filesAll );
 				return curPosition;
 			}
+		}
 
-			if ( curPosition > dirFirstLast[ curLevel ].first )
-			{
-				if ( -- curPosition < dirFirstLast[ curLevel ].first + dirFirstLast[ curLevel ].scrollPos )
-					dirFirstLast[ curLevel ].scrollPos --;
-			}
+		if ( ( e->f & REUDIR_DIRECTORY ) && isOnPath( e, search ) && expandDirectory( cat, e ) )
+		{
+			// go into directory
+			first = e->first;
+			last = e->last + 1;
+			i = first - 1;
 		}
 	}
+
+	return -1;
 }
 
+void saveCurrentCursor();
 
-void scanDirectoriesRAD( char *DRIVE )
+u32 browserSearchActive = 0;
+static char searchStr[ SEARCH_MAX_LENGTH + 1 ];
+static u32 searchLength, searchCur, searchN;
+
+static int searchSavedCategory;
+static int searchSavedPositionCat[ BROWSER_NUM_CATEGORIES ];
+static int searchSavedLevelCat[ BROWSER_NUM_CATEGORIES ];
+static BROWSESTATE searchSavedDirFirstLastCat[ BROWSER_NUM_CATEGORIES ][ 32 ];
+
+static void startSearch()
 {
-	FATFS m_FileSystem;
+	SAVE_CATEGORY( curCategory );
+	searchSavedCategory = curCategory;
+	memcpy( searchSavedPositionCat, curPositionCat, sizeof( int ) * BROWSER_NUM_CATEGORIES );
+	memcpy( searchSavedLevelCat, curLevelCat, sizeof( int ) * BROWSER_NUM_CATEGORIES );
+	memcpy( searchSavedDirFirstLastCat, dirFirstLastCat, sizeof( BROWSESTATE ) * BROWSER_NUM_CATEGORIES * 32 );
+
+	expandAllDirectories();
+	searchBuildIndex();
+
+	searchStr[ 0 ] = 0;
+	searchLength = searchCur = searchN = 0;
+	browserSearchActive = 1;
+}
+
+// keys while searching: characters extend the query, DEL removes the last one, cursor up/down go through the results,
+// RETURN stays at the current result and '<-' goes back to where the search started
+static u32 handleSearchKey( int k )
+{
+	if ( k == VK_ESC )
+	{
+		memcpy( curPositionCat, searchSavedPositionCat, sizeof( int ) * BROWSER_NUM_CATEGORIES );
+		memcpy( curLevelCat, searchSavedLevelCat, sizeof( int ) * BROWSER_NUM_CATEGORIES );
+		memcpy( dirFirstLastCat, searchSavedDirFirstLastCat, sizeof( BROWSESTATE ) * BROWSER_NUM_CATEGORIES * 32 );
+		curCategory = searchSavedCategory;
+		LOAD_CATEGORY( curCategory );
+		browserSearchActive = 0;
+		return 0;
+	}
+
+	if ( k == VK_RETURN )
+	{
+		browserSearchActive = 0;
+		saveCurrentCursor();
+		return 0;
+	}
+
+	if ( ( k == VK_DOWN || k == VK_F3 ) && searchCur + 1 < searchN )
+		searchCur ++; else
+	if ( ( k == VK_UP || k == VK_F1 ) && searchCur > 0 )
+		searchCur --; else
+	if ( k == VK_DELETE && searchLength > 0 )
+	{
+		searchStr[ -- searchLength ] = 0;
+		searchN = searchQuery( searchStr, 0 );
+		searchCur = 0;
+	} else
+	if ( ( ( k >= 'A' && k <= 'Z' ) || ( k >= '0' && k <= '9' ) || k == '.' || k == '-' || k == '+' || k == VK_SPACE ) && searchLength < SEARCH_MAX_LENGTH )
+	{
+		searchStr[ searchLength ++ ] = k;
+		searchStr[ searchLength ] = 0;
+		searchN = searchQuery( searchStr, searchLength > 1 );
+		searchCur = 0;
+	} else
+		return 0;
+
+	if ( searchCur < searchN )
+	{
+		u32 r = searchResult( searchCur );
+		showEntry( SEARCH_CATEGORY( r ), SEARCH_INDEX( r ) );
+	}
+
+	return 0;
+}
 
+void scanDirectoriesRAD( char *DRIVE )
+{
 	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+	if ( fsMount( DRIVE ) != FR_OK )
 		logger->Write( "RaspiMenu", LogPanic, "Cannot mount drive: %s", DRIVE );
 
 	u32 n = 0, nElementsLevel0 = 0, tmp;
 
+	dirArenaUsed = 1;
+	nFileOpsPending = 0;
+	browserSearchActive = 0;
+	searchInvalidate();
+
 	memset( curLevelCat, 0, sizeof( int ) * BROWSER_NUM_CATEGORIES );
 	memset( curPositionCat, 0, sizeof( int ) * BROWSER_NUM_CATEGORIES );
 	memset( dirFirstLastCat, 0, sizeof( BROWSESTATE ) * 32 * BROWSER_NUM_CATEGORIES );
@@ -457,7 +742,10 @@ void scanDirectoriesRAD( char *DRIVE )
 	{
 		tmp = nElementsLevel0 = 0;
 		filePtrCat[ c ] = &filesAll[ n ];
-		ListDirectoryContents( (const char*)scanDirs[ c ], &filesAll[ n ], &tmp, &nElementsLevel0, 0xffffffff, 0, bAddNewImage[ c ] );
+		categoryRoot[ c ] = REUDIR_ROOT | dirArenaAdd( scanDirs[ c ] );
+		dirCacheSelect( c );
+		ListDirectoryContents( (const char*)scanDirs[ c ], categoryRoot[ c ], &filesAll[ n ], &tmp, &nElementsLevel0, 0xffffffff, 0, bAddNewImage[ c ] );
+		dirCacheFlush( logger );
 		n += tmp;
 		dirFirstLastCat[ c ][ 0 ].last = nElementsLevel0;
 		nTotalElements[ c ] = nElementsLevel0;
@@ -465,10 +753,6 @@ void scanDirectoriesRAD( char *DRIVE )
 
 	nFilesAllCategories = n;
 
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RaspiMenu", LogPanic, "Cannot unmount drive: %s", DRIVE );
-
 	curCategory = 0;
 
 	if ( firstTimeScanning )
@@ -490,6 +774,8 @@ void scanDirectoriesRAD( char *DRIVE )
 			memcpy( curPositionCat, prevPositionCat, sizeof( int ) * BROWSER_NUM_CATEGORIES);
 			memcpy( curLevelCat, prevLevelCat, sizeof( int ) * BROWSER_NUM_CATEGORIES);
 			memcpy( dirFirstLastCat, prevDirFirstLastCat, sizeof( BROWSESTATE ) * BROWSER_NUM_CATEGORIES * 32 );
+			for ( int c = 0; c < BROWSER_NUM_CATEGORIES; c ++ )
+				restoreOpenDirectories( c );
 		} else
 		{
 			findFile( 0, dirSelectedFilePRG );
@@ -515,7 +801,8 @@ void saveCurrentCursor()
  		 e->f & REUDIR_GEOIMAGE ||
 		 e->f & REUDIR_PRG  )
 	{
-		sprintf( dirSelectedFile, "%s/%s", (const char*)files[ curPosition ].path, (const char*)files[ curPosition ].filename );
+		char path[ 1024 ];
+		sprintf( dirSelectedFile, "%s/%s", dirEntryPath( e, path ), DIRENTRY_FILENAME( e ) );
 
 		if ( e->f & REUDIR_REUIMAGE )
 			strncpy( dirSelectedFileREU, dirSelectedFile, 1023 ); else
@@ -564,13 +851,11 @@ void applyAllPendingFileoperations( const char *DRIVE )
 
 	nFileOpsPending = 0;
 
-	FATFS m_FileSystem;
-
 	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+	if ( fsMount( DRIVE ) != FR_OK )
 		logger->Write( "RaspiMenu", LogPanic, "Cannot mount drive: %s", DRIVE );
 
-	char curSelectedFile[ 1024 ];
+	char curSelectedFile[ 2048 ], path[ 1024 ];
 	curSelectedFile[ 0 ] = 0;
 
 	int myCurCategory = curCategory;
@@ -582,7 +867,7 @@ void applyAllPendingFileoperations( const char *DRIVE )
 		{
 			if ( -- curPosition < dirFirstLast[ curLevel ].first + dirFirstLast[ curLevel ].scrollPos )
 				dirFirstLast[ curLevel ].scrollPos --;
-			sprintf( curSelectedFile, "%s/%s", (const char*)files[ curPosition ].path, (const char*)files[ curPosition ].filename );
+			sprintf( curSelectedFile, "%s/%s", dirEntryPath( &files[ curPosition ], path ), DIRENTRY_FILENAME( &files[ curPosition ] ) );
 		} else
 		if ( curPosition < dirFirstLast[ curLevel ].last - 1 )
 		{
@@ -591,7 +876,7 @@ void applyAllPendingFileoperations( const char *DRIVE )
 			if ( ++ curPosition >= dirFirstLast[ curLevel ].first + dirFirstLast[ curLevel ].scrollPos + BROWSER_NUM_LINES )
 				dirFirstLast[ curLevel ].scrollPos ++;
 		
-			sprintf( curSelectedFile, "%s/%s", (const char*)files[ curPosition ].path, (const char*)files[ curPosition ].filename );
+			sprintf( curSelectedFile, "%s/%s", dirEntryPath( &files[ curPosition ], path ), DIRENTRY_FILENAME( &files[ curPosition ] ) );
 		} 
 	}
 
@@ -600,22 +885,19 @@ void applyAllPendingFileoperations( const char *DRIVE )
 		if ( files[ i ].fileOp & REUDIR_FILEOP_DELETE )
 		{
 			char fn[ 2048 ];
-			sprintf( fn, "%s/%s", files[ i ].path, files[ i ].filename );
+			sprintf( fn, "%s/%s", dirEntryPath( &files[ i ], path ), DIRENTRY_FILENAME( &files[ i ] ) );
 			f_unlink( fn );
 		} else
 		if ( files[ i ].fileOp & REUDIR_FILEOP_RENAME )
 		{
 			char oldName[ 2048 ], newName[ 2048 ];
-			sprintf( oldName, "%s/%s", files[ i ].path, files[ i ].filename );
-			sprintf( newName, "%s/%s", files[ i ].path, files[ i ].rename );
+			dirEntryPath( &files[ i ], path );
+			sprintf( oldName, "%s/%s", path, DIRENTRY_FILENAME( &files[ i ] ) );
+			sprintf( newName, "%s/%s", path, DIRENTRY_RENAME( &files[ i ] ) );
 			f_rename( oldName, newName );
 		}
 	}
 
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RaspiMenu", LogPanic, "Cannot unmount drive: %s", DRIVE );
-
 	firstTimeScanning = 1;
 	scanDirectoriesRAD( (char*)DRIVE );
 	if ( curSelectedFile[ 0 ] )
@@ -658,6 +940,14 @@ char warningMessage[ 41 ];
 
 u32 handleKey( int k )
 {
+	if ( browserSearchActive )
+		return handleSearchKey( k );
+
+	if ( k == '/' )
+	{
+		startSearch();
+		return 0;
+	} else
 	if ( k == VK_F1 || k == VK_F3 )
 	{
 		for ( int i = 0; i < 10; i++ )
@@ -686,7 +976,7 @@ u32 handleKey( int k )
 	if ( k == VK_RETURN || k == VK_SHIFT_RETURN || k == VK_COMMODORE_RETURN )
 	{
 		REUDIRENTRY *e = &files[ curPosition ];
-		if ( ( e->f & REUDIR_DIRECTORY ) && ( e->last > e->first ) )
+		if ( ( e->f & REUDIR_DIRECTORY ) && expandDirectory( curCategory, e ) )
 		{
 			curLevel ++;
 			dirFirstLast[ curLevel ].first  = e->first;
@@ -701,8 +991,9 @@ u32 handleKey( int k )
 			 e->f & REUDIR_GEOIMAGE ||
 			 e->f & REUDIR_PRG  )
 		{
-			sprintf( dirSelectedFile, "%s/%s", (const char*)files[ curPosition ].path, (const char*)files[ curPosition ].filename );
-			strncpy( dirSelectedName, (const char*)files[ curPosition ].filename, 511 );
+			char path[ 1024 ];
+			sprintf( dirSelectedFile, "%s/%s", dirEntryPath( e, path ), DIRENTRY_FILENAME( e ) );
+			strncpy( dirSelectedName, DIRENTRY_FILENAME( e ), 511 );
 			dirSelectedFileSize = files[ curPosition ].size;
 
 			saveCurrentCursor();
@@ -765,7 +1056,7 @@ u32 handleKey( int k )
 			if ( !( e->fileOp & REUDIR_FILEOP_RENAME ) )
 			{
 				nFileOpsPending ++;
-				memcpy( e->rename, e->filename, 64 );
+				e->rename = e->filename;
 				e->fileOp |= REUDIR_FILEOP_RENAME;
 			}
 
@@ -782,19 +1073,23 @@ u32 handleKey( int k )
 		if ( e->f & REUDIR_D64 ||
 			 e->f & REUDIR_PRG )
 		{
+			char path[ 1024 ], name[ 64 ];
+			dirEntryPath( e, path );
+			makeFormattedName( e, name );
+
 			if ( !(e->f & REUDIR_MARKSYNC) )
 			{
-				int idx = indexOfSyncFile_FileNameSize( syncRemoveFiles, nRemoveFiles, (char*)e->filename, e->size );
+				int idx = indexOfSyncFile_FileNameSize( syncRemoveFiles, nRemoveFiles, (char*)DIRENTRY_FILENAME( e ), e->size );
 				if ( idx != -1 )
 				{
 					// file exists on IECDevice and we marked it for deletion. Now we undo this!
-					removeSyncFile( syncRemoveFiles, &nRemoveFiles, (char*)e->path, (char*)e->filename, (char*)e->name, e->size );
+					removeSyncFile( syncRemoveFiles, &nRemoveFiles, path, (char*)DIRENTRY_FILENAME( e ), name, e->size );
 					e->f |= REUDIR_MARKSYNC;
 				} else
 				{
 					// we avoid name clashes as on iecdevice files will be identified by "name" only
-					int idx1 = indexOfSyncFile_FileNameOnly( syncFileOnDevice, nSyncFileOnDevice, (char*)e->filename );
-					int idx2 = indexOfSyncFile_FileNameOnly( syncFileChanges, nSyncFileChanges, (char*)e->filename );
+					int idx1 = indexOfSyncFile_FileNameOnly( syncFileOnDevice, nSyncFileOnDevice, (char*)DIRENTRY_FILENAME( e ) );
+					int idx2 = indexOfSyncFile_FileNameOnly( syncFileChanges, nSyncFileChanges, (char*)DIRENTRY_FILENAME( e ) );
 
 					if ( idx1 != -1 || idx2 != -1 )
 					{
@@ -807,7 +1102,7 @@ u32 handleKey( int k )
 					} else
 					{
 						// 2 or more files on SD-card (from different subdirectories may have the same filename)
-						addSyncFile( syncFileChanges, &nSyncFileChanges, (char*)e->path, (char*)e->filename, (char*)e->name, e->size, 0 );
+						addSyncFile( syncFileChanges, &nSyncFileChanges, path, (char*)DIRENTRY_FILENAME( e ), name, e->size, 0 );
 						e->f |= REUDIR_MARKSYNC;
 					}
 				}
@@ -815,15 +1110,15 @@ u32 handleKey( int k )
 			{
 				e->f &= ~REUDIR_MARKSYNC;
 				// remove from list of files to be synced
-				int idxA = indexOfSyncFile_FileNameSize( syncFileOnDevice, nSyncFileOnDevice, (char*)e->filename, e->size );
+				int idxA = indexOfSyncFile_FileNameSize( syncFileOnDevice, nSyncFileOnDevice, (char*)DIRENTRY_FILENAME( e ), e->size );
 				if ( idxA != -1 )
 				{
 					// file is on the IECDevice and we mark the file to deletion
-					addSyncFile( syncRemoveFiles, &nRemoveFiles, (char*)e->path, (char*)e->filename, (char*)e->name, e->size, 0 );
+					addSyncFile( syncRemoveFiles, &nRemoveFiles, path, (char*)DIRENTRY_FILENAME( e ), name, e->size, 0 );
 				} else
 				{
 					// file is not yet on IECDevice, it has just been added to the list for syncing, and we'll remove it from there
-					removeSyncFile( syncFileChanges, &nSyncFileChanges, (char*)e->path, (char*)e->filename, (char*)e->name, e->size );
+					removeSyncFile( syncFileChanges, &nSyncFileChanges, path, (char*)DIRENTRY_FILENAME( e ), name, e->size );
 				}
 			}
 		}
@@ -905,6 +1200,14 @@ void printBrowser( int fade )
 	printC64( xp+4, yp, "REU", c, (curCategory==1)?0x80:0, 0, 4 );
 	printC64( xp+8, yp, "GEORAM", c, (curCategory==2)?0x80:0, 0, 6 );
 
+	printC64( xp+15, yp, "                ", 0, 0, 0, 16 );
+	if ( browserSearchActive )
+	{
+		char t[ SEARCH_MAX_LENGTH + 2 ];
+		sprintf( t, "/%s", searchStr );
+		printC64( xp+15, yp, t, searchN ? c : fadeTabStep[ 10 ][ fade ], 0, 0, 16 );
+	}
+
 	yp ++;
 
 	extern u8 c64ScreenRAM[ 1024 * 4 ]; 
@@ -928,14 +1231,14 @@ void printBrowser( int fade )
 			color = 14; 
 
 		u8 printName[ 64 ];
+		makeFormattedName( &files[ i ], (char*)printName );
+
 		if ( files[ i ].f & REUDIR_MARKSYNC )
 		{
-			memcpy( printName, files[ i ].name, 64 );
 			printC64( xp-1, yp, (const char*)"\x5b", color, 0 /*i == curPosition ? 0x80 : 0*/, 0, 39 );
 			printC64( xp, yp, (const char*)printName, color, i == curPosition ? 0x80 : 0, 0, 39 );
 		} else
 		{
-			memcpy( printName, files[ i ].name, 64 );
 			printC64( xp, yp, (const char*)printName, color, i == curPosition ? 0x80 : 0, 0, 39 );
 		}
 
@@ -42,12 +42,6 @@
 
 #define DISPLAY_LINES 11
 
-typedef struct
-{
-	u8	name[ 256 ];
-	u32 f, parent, next, level, size;
-} DIRENTRY;
-
 // file type requires 3 bits
 #define SHIFT_TYPE		16
 
@@ -64,6 +58,7 @@ typedef struct
 #define REUDIR_D64			0x80
 #define REUDIR_ZIP			0x100
 #define REUDIR_SEQ			0x200
+#define REUDIR_UNSCANNED	0x400
 
 #define BROWSER_NUM_CATEGORIES	3
 #define BROWSER_NUM_LINES		10
@@ -71,8 +66,6 @@ typedef struct
 #define ITEM_SELECTED 128
 
 #define MAX_DIR_ENTRIES		16384
-extern DIRENTRY dir[ MAX_DIR_ENTRIES ];
-extern s32 nDirEntries;
 extern int nFilesAllCategories;
 
 #define REUMENU_SELECT_FILE_REU	(1<<24)
@@ -93,14 +86,35 @@ extern u32 dirSelectedFileSize;
 #define REUDIR_FILEOP_DELETE  0x01
 #define REUDIR_FILEOP_RENAME  0x02
 
+// file names are stored in one string arena which is refilled with every scan (offset 0 is the empty string); the path of
+// an entry is not stored, but the index of the entry of its directory in filesAll (or the arena offset of the root path)
+#define DIR_ARENA_SIZE		( 2 * 1024 * 1024 )
+#define REUDIR_ROOT			0x80000000
+
 typedef struct
 {
-	u8  path[ 1024 ];
-	u8  filename[ 256 ];
-	u8	name[ 256 ];
+	u32 filename, rename;	// offsets into dirArena
+	u32 dir;				// index of the directory's entry, or REUDIR_ROOT | offset of the root path
 	u32 f, size, first, last, parent;
-  u32 fileOp;
-  u8  rename[ 256 ];
+	u32 fileOp;
 } REUDIRENTRY;
 
+extern char dirArena[ DIR_ARENA_SIZE ];
+extern REUDIRENTRY filesAll[ MAX_DIR_ENTRIES ];
+
+// returns the arena offset of a copy of s, or 0 (the empty string) if the arena is full
+extern u32 dirArenaAdd( const char *s );
+
+#define DIRENTRY_FILENAME( e )	( (const char*)&dirArena[ (e)->filename ] )
+#define DIRENTRY_RENAME( e )	( (const char*)&dirArena[ (e)->rename ] )
+
+// reconstructs the path of an entry (without its filename), returns path
+extern char *dirEntryPath( const REUDIRENTRY *e, char *path );
+
+// formats the name as displayed by the browser (name and size), name must hold 64 characters
+extern void makeFormattedName( const REUDIRENTRY *d, char *name );
+
+// returns the browser category an entry belongs to, or -1
+extern int dirEntryCategory( const REUDIRENTRY *e );
+
 #endif
@@ -0,0 +1,159 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - type-ahead search in the menu browser
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "linux/kernel.h"
+#include "dirsearch.h"
+
+#define FOLD( c )	( ( (c) >= 'a' && (c) <= 'z' ) ? (c) - 'a' + 'A' : (c) )
+
+static u32 searchTable[ MAX_DIR_ENTRIES ], searchTmp[ MAX_DIR_ENTRIES ];
+static u32 nSearchTable = 0, searchIndexValid = 0;
+
+static u32 searchResults[ MAX_DIR_ENTRIES ];
+static u32 nSearchResults = 0;
+
+static int compareNames( const char *a, const char *b )
+{
+	while ( *a && FOLD( *a ) == FOLD( *b ) )
+		a ++, b ++;
+	return (int)(u8)FOLD( *a ) - (int)(u8)FOLD( *b );
+}
+
+// < 0, 0, > 0 if name sorts before, starts with, or sorts after the prefix
+static int comparePrefix( const char *name, const char *prefix )
+{
+	while ( *prefix && FOLD( *name ) == FOLD( *prefix ) )
+		name ++, prefix ++;
+	if ( *prefix == 0 )
+		return 0;
+	return (int)(u8)FOLD( *name ) - (int)(u8)FOLD( *prefix );
+}
+
+static bool containsName( const char *name, const char *query )
+{
+	for ( ; *name; name++ )
+		if ( comparePrefix( name, query ) == 0 )
+			return true;
+	return false;
+}
+
+#define SEARCH_NAME( r )	DIRENTRY_FILENAME( &filesAll[ SEARCH_INDEX( r ) ] )
+
+// bottom-up merge sort: the entries come in runs (the sorted directory levels) which would make a simple quicksort quadratic
+static void sortTable( u32 n )
+{
+	u32 *src = searchTable, *dst = searchTmp;
+
+	for ( u32 w = 1; w < n; w <<= 1 )
+	{
+		for ( u32 lo = 0; lo < n; lo += 2 * w )
+		{
+			u32 mid = min( lo + w, n ), hi = min( lo + 2 * w, n );
+			u32 i = lo, j = mid, k = lo;
+			while ( i < mid && j < hi )
+				dst[ k ++ ] = compareNames( SEARCH_NAME( src[ j ] ), SEARCH_NAME( src[ i ] ) ) < 0 ? src[ j ++ ] : src[ i ++ ];
+			while ( i < mid ) dst[ k ++ ] = src[ i ++ ];
+			while ( j < hi ) dst[ k ++ ] = src[ j ++ ];
+		}
+		u32 *t = src; src = dst; dst = t;
+	}
+
+	if ( src != searchTable )
+		memcpy( searchTable, src, n * sizeof( u32 ) );
+}
+
+void searchInvalidate()
+{
+	searchIndexValid = 0;
+	nSearchResults = 0;
+}
+
+void searchBuildIndex()
+{
+	if ( searchIndexValid )
+		return;
+
+	nSearchTable = 0;
+	for ( int i = 0; i < nFilesAllCategories; i++ )
+	{
+		REUDIRENTRY *e = &filesAll[ i ];
+		if ( e->f & ( REUDIR_TOPARENT | REUDIR_DUMMYNEW ) )
+			continue;
+
+		int cat = dirEntryCategory( e );
+		if ( cat >= 0 )
+			searchTable[ nSearchTable ++ ] = SEARCH_RESULT( cat, i );
+	}
+
+	sortTable( nSearchTable );
+
+	searchIndexValid = 1;
+	nSearchResults = 0;
+}
+
+u32 searchQuery( const char *query, u32 incremental )
+{
+	if ( query[ 0 ] == 0 )
+		return nSearchResults = 0;
+
+	if ( incremental )
+	{
+		u32 n = 0;
+		for ( u32 i = 0; i < nSearchResults; i++ )
+			if ( containsName( SEARCH_NAME( searchResults[ i ] ), query ) )
+				searchResults[ n ++ ] = searchResults[ i ];
+		return nSearchResults = n;
+	}
+
+	// first name not sorting before the prefix
+	u32 lo = 0, hi = nSearchTable;
+	while ( lo < hi )
+	{
+		u32 mid = ( lo + hi ) / 2;
+		if ( comparePrefix( SEARCH_NAME( searchTable[ mid ] ), query ) < 0 )
+			lo = mid + 1; else
+			hi = mid;
+	}
+
+	u32 firstPrefix = lo, lastPrefix = lo;
+	nSearchResults = 0;
+	while ( lastPrefix < nSearchTable && comparePrefix( SEARCH_NAME( searchTable[ lastPrefix ] ), query ) == 0 )
+		searchResults[ nSearchResults ++ ] = searchTable[ lastPrefix ++ ];
+
+	for ( u32 i = 0; i < nSearchTable; i++ )
+		if ( ( i < firstPrefix || i >= lastPrefix ) && containsName( SEARCH_NAME( searchTable[ i ] ), query ) )
+			searchResults[ nSearchResults ++ ] = searchTable[ i ];
+
+	return nSearchResults;
+}
+
+u32 searchResult( u32 i )
+{
+	return searchResults[ i ];
+}
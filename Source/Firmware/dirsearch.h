@@ -0,0 +1,56 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - type-ahead search in the menu browser
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _dirsearch_h
+#define _dirsearch_h
+
+#include <circle/types.h>
+#include "dirscan.h"
+
+// the files and directories of all categories are kept in a table sorted by name (case-insensitive). A query is first
+// looked up as a prefix of the names (binary search), then as a substring; results are the prefix matches followed by the
+// substring matches, both in alphabetical order. When a character is appended to the query only the previous results
+// need to be checked again, as every name which contains the new query also contained the old one
+#define SEARCH_MAX_LENGTH		14
+
+// a result is the index of the entry in filesAll and its category
+#define SEARCH_RESULT( cat, idx )	( ( (u32)( cat ) << 24 ) | ( idx ) )
+#define SEARCH_CATEGORY( r )		( (r) >> 24 )
+#define SEARCH_INDEX( r )			( (r) & 0xffffff )
+
+// builds the table from all entries in filesAll (all directories should have been scanned), unless it is up to date
+extern void searchBuildIndex();
+
+// the table has to be rebuilt after the directories have been scanned again
+extern void searchInvalidate();
+
+// returns the number of results, incremental = 1 if query is the previous query with characters appended
+extern u32 searchQuery( const char *query, u32 incremental );
+extern u32 searchResult( u32 i );
+
+#endif
@@ -0,0 +1,157 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - fingerprints of REU images (CRC-32, cached on the SD card)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "helpers.h"
+#include "lowlevel_arm64.h"
+#include "crc32.h"
+#include "rad_reu.h"
+#include "fingerprint.h"
+
+u32 reuImageFingerprint = 0, reuImageSpecial = 0;
+
+// the 8-cycle wait of NUVIE header fetches in handle_transfer.h depends on this
+u32 reuImageIsNuvie( const u8 *m, u32 size )
+{
+	u8 pat1[ 16 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };	// 0x8f00f0
+	u8 pat2[ 7 ] = { 0x30, 0x30, 0x31, 0x16, 0x31, 0x2e, 0x30 }; // 0x0000f5
+	if ( ( size >= 0x8f0100 && memcmp( pat1, &m[ 0x8f00f0 ], 16 ) == 0 ) || ( size >= 0x100 && memcmp( pat2, &m[ 0x0000f5 ], 7 ) == 0 ) )
+		return SPECIAL_NUVIE;
+	return 0;
+}
+
+static FINGERPRINTCACHE fpCache AAA;
+static u32 fpCacheLoaded = 0;
+
+// FAT file names are not case sensitive
+static u32 fingerprintPathHash( const char *FILENAME )
+{
+	u32 crc = 0xffffffff;
+	for ( const char *c = FILENAME; *c; c++ )
+	{
+		u8 ch = ( *c >= 'a' && *c <= 'z' ) ? *c - 'a' + 'A' : *c;
+		crc = crc32Update( crc, &ch, 1 );
+	}
+	return ~crc;
+}
+
+static void fingerprintLoadCache()
+{
+	FIL file;
+	u32 nBytesRead;
+
+	fpCacheLoaded = 1;
+	memset( &fpCache, 0, sizeof( FINGERPRINTCACHE ) );
+
+	if ( f_open( &file, FINGERPRINT_CACHE_FILE, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+		return;
+
+	if ( f_read( &file, &fpCache, sizeof( FINGERPRINTCACHE ), &nBytesRead ) != FR_OK || nBytesRead != sizeof( FINGERPRINTCACHE ) ||
+		 fpCache.magic != FINGERPRINT_MAGIC || fpCache.nEntries > FINGERPRINT_ENTRIES || fpCache.next >= FINGERPRINT_ENTRIES )
+		memset( &fpCache, 0, sizeof( FINGERPRINTCACHE ) );
+
+	f_close( &file );
+}
+
+static void fingerprintSaveCache( CLogger *logger )
+{
+	FIL file;
+	u32 nBytesWritten;
+
+	if ( f_open( &file, FINGERPRINT_CACHE_FILE, FA_WRITE | FA_CREATE_ALWAYS ) != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot write file: %s", FINGERPRINT_CACHE_FILE );
+		return;
+	}
+
+	fpCache.magic = FINGERPRINT_MAGIC;
+	f_write( &file, &fpCache, sizeof( FINGERPRINTCACHE ), &nBytesWritten );
+	f_close( &file );
+}
+
+// finds the cache entry of FILENAME as it is on the SD card now, returns 0 if there is no such file
+static u32 fingerprintFind( const char *FILENAME, FILINFO *info, u32 *pathHash, FINGERPRINTENTRY **entry )
+{
+	*entry = NULL;
+
+	if ( f_stat( FILENAME, info ) != FR_OK )
+		return 0;
+
+	if ( !fpCacheLoaded )
+		fingerprintLoadCache();
+
+	*pathHash = fingerprintPathHash( FILENAME );
+
+	for ( u32 i = 0; i < fpCache.nEntries; i++ )
+	{
+		FINGERPRINTENTRY *e = &fpCache.entry[ i ];
+		if ( e->pathHash == *pathHash && e->size == (u32)info->fsize && e->date == info->fdate && e->time == info->ftime )
+			*entry = e;
+	}
+
+	return 1;
+}
+
+u32 fingerprintLookup( const char *FILENAME, u32 *fingerprint, u32 *special )
+{
+	FILINFO info;
+	u32 pathHash;
+
+	FINGERPRINTENTRY *e;
+
+	fingerprintFind( FILENAME, &info, &pathHash, &e );
+	*fingerprint = e ? e->crc : 0;
+	*special = e ? e->special : 0;
+	return e ? 1 : 0;
+}
+
+void fingerprintStore( CLogger *logger, const char *FILENAME, u32 crc, u32 special )
+{
+	FILINFO info;
+	u32 pathHash;
+
+	FINGERPRINTENTRY *e;
+
+	if ( !fingerprintFind( FILENAME, &info, &pathHash, &e ) || e )
+		return;
+
+	// unknown (or modified) image: replace the oldest entry
+	e = &fpCache.entry[ fpCache.next ];
+	e->pathHash = pathHash;
+	e->size = (u32)info.fsize;
+	e->date = info.fdate;
+	e->time = info.ftime;
+	e->crc = crc;
+	e->special = special;
+
+	fpCache.next = ( fpCache.next + 1 ) % FINGERPRINT_ENTRIES;
+	if ( fpCache.nEntries < FINGERPRINT_ENTRIES )
+		fpCache.nEntries ++;
+
+	fingerprintSaveCache( logger );
+}
@@ -0,0 +1,71 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - fingerprints of REU images (CRC-32, cached on the SD card)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _fingerprint_h
+#define _fingerprint_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// an REU image is identified by the CRC-32 of its contents (see crc32.h); computing it for 16 MB takes a while even
+// with the CRC instructions, so the fingerprints of recently loaded images are kept in a small file on the SD card,
+// keyed by path, size and time stamp of the image file
+#define FINGERPRINT_CACHE_FILE	"SD:RAD/fingerprints.bin"
+#define FINGERPRINT_MAGIC		0x46444152		// "RADF"
+#define FINGERPRINT_ENTRIES		256
+
+// titles which need special handling
+#define FINGERPRINT_BLUREU		0x2a9634da
+
+typedef struct
+{
+	u32 pathHash, size, date, time;
+	u32 crc;
+	u32 special;		// result of reuImageIsNuvie()
+} FINGERPRINTENTRY;
+
+typedef struct
+{
+	u32 magic, nEntries, next, reserved;
+	FINGERPRINTENTRY entry[ FINGERPRINT_ENTRIES ];
+} FINGERPRINTCACHE;
+
+// fingerprint of the image the REU emulation currently runs with, 0 if none (empty REU or from a VSF), and the
+// SPECIAL_xxx flags which follow from its contents rather than from its fingerprint (i.e. NUVIE videos)
+extern u32 reuImageFingerprint, reuImageSpecial;
+
+// NUVIE videos are recognized by signatures at fixed addresses (m holds the first size bytes of the image)
+extern u32 reuImageIsNuvie( const u8 *m, u32 size );
+
+// returns 1, the fingerprint and special flags if FILENAME is in the cache (the file system must be mounted)
+extern u32 fingerprintLookup( const char *FILENAME, u32 *fingerprint, u32 *special );
+
+// records crc and special flags of the image FILENAME (the file system must be mounted)
+extern void fingerprintStore( CLogger *logger, const char *FILENAME, u32 crc, u32 special );
+
+#endif
@@ -0,0 +1,154 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - freezing the running C64 to a Vice snapshot (VSF)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "helpers.h"
+#include "lowlevel_arm64.h"
+#include "rad_hijack.h"
+#include "rad_reu.h"
+#include "freeze.h"
+
+// switched on with "FREEZE ON" in rad.cfg
+u32 radFreeze = 0;
+
+FREEZESTATE freezeState AAA;
+
+// module data as far as resetAndInjectVSF() and the VSF loading in rad_main.cpp read it,
+// Vice's module versions are not checked by the RAD
+#define FREEZE_SIZE_MAINCPU		16
+#define FREEZE_SIZE_C64MEM		( 4 + 65536 )
+#define FREEZE_SIZE_CIA			20
+#define FREEZE_SIZE_SID			0x20
+#define FREEZE_SIZE_VIC			( 761 + 1024 )
+#define FREEZE_SIZE_REU			20
+
+static u8 module[ FREEZE_SIZE_VIC ] AAA;
+
+static u32 freezeWrite( FIL *file, const void *data, u32 size )
+{
+	u32 nBytesWritten;
+	return f_write( file, data, size, &nBytesWritten ) == FR_OK && nBytesWritten == size;
+}
+
+// module header (name, version, size including the header) followed by the data, which may come in two parts
+static u32 freezeWriteModule( FIL *file, const char *name, const u8 *data, u32 size, const u8 *data2 = NULL, u32 size2 = 0 )
+{
+	u8 h[ VSF_SIZE_MODULE_HEADER ];
+	u32 total = VSF_SIZE_MODULE_HEADER + size + size2;
+
+	memset( h, 0, VSF_SIZE_MODULE_HEADER );
+	strncpy( (char*)h, name, 16 );
+	h[ 16 ] = 1;
+	for ( u32 i = 0; i < 4; i++ )
+		h[ 18 + i ] = ( total >> ( i * 8 ) ) & 255;
+
+	return freezeWrite( file, h, VSF_SIZE_MODULE_HEADER ) && freezeWrite( file, data, size ) && 
+		   ( size2 == 0 || freezeWrite( file, data2, size2 ) );
+}
+
+int freezeWriteVSF( CLogger *logger, const char *DRIVE, const char *FILENAME, FREEZESTATE *f, u8 *reuMem, u32 reuSizeKB )
+{
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	FIL file;
+	if ( f_open( &file, FILENAME, FA_WRITE | FA_CREATE_ALWAYS ) != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
+		return 0;
+	}
+
+	u32 ok = 1;
+
+	// header: magic, version 2.0, machine name, Vice version
+	memset( module, 0, 0x3a );
+	memcpy( &module[ 0 ], "VICE Snapshot File\032", 19 );
+	module[ 19 ] = 2;
+	memcpy( &module[ 21 ], "C64SC", 5 );
+	memcpy( &module[ 37 ], "VICE Version\032", 13 );
+	module[ 50 ] = 3; module[ 51 ] = 8;
+	ok &= freezeWrite( &file, module, 0x3a );
+
+	// CPU
+	memset( module, 0, FREEZE_SIZE_MAINCPU );
+	module[ 8 ]  = f->a;
+	module[ 9 ]  = f->x;
+	module[ 10 ] = f->y;
+	module[ 11 ] = f->sp;
+	module[ 12 ] = f->pc & 255;
+	module[ 13 ] = f->pc >> 8;
+	module[ 14 ] = f->p;
+	ok &= freezeWriteModule( &file, "MAINCPU", module, FREEZE_SIZE_MAINCPU );
+
+	// CPU port and RAM
+	memset( module, 0, 4 );
+	module[ 0 ] = f->port1;
+	module[ 1 ] = f->port0;
+	ok &= freezeWriteModule( &file, "C64MEM", module, 4, f->ram, 65536 );
+
+	ok &= freezeWriteModule( &file, "CIA1", f->cia1, FREEZE_SIZE_CIA );
+	ok &= freezeWriteModule( &file, "CIA2", f->cia2, FREEZE_SIZE_CIA );
+	ok &= freezeWriteModule( &file, "SIDEXTENDED", f->sid, FREEZE_SIZE_SID );
+
+	// VIC registers, raster position and color RAM
+	memset( module, 0, FREEZE_SIZE_VIC );
+	memcpy( &module[ 1 ], f->vic, 0x2f );
+	module[ 0x40 ] = f->rasterCycle;
+	module[ 0x48 ] = ( f->rasterLine >> 1 ) & 0x80;
+	module[ 0x49 ] = f->rasterLine & 255;
+	memcpy( &module[ 761 ], f->colorRAM, 1024 );
+	ok &= freezeWriteModule( &file, "VIC-II", module, FREEZE_SIZE_VIC );
+
+	// REU registers and memory
+	if ( reuMem )
+	{
+		memset( module, 0, FREEZE_SIZE_REU );
+		for ( u32 i = 0; i < 4; i++ )
+			module[ i ] = ( reuSizeKB >> ( i * 8 ) ) & 255;
+		module[ 4 ]  = reu.status;
+		module[ 5 ]  = reu.command;
+		module[ 6 ]  = reu.addrC64 & 255;
+		module[ 7 ]  = reu.addrC64 >> 8;
+		module[ 8 ]  = reu.addrREU & 255;
+		module[ 9 ]  = reu.addrREU >> 8;
+		module[ 10 ] = reu.bank;
+		module[ 11 ] = reu.length & 255;
+		module[ 12 ] = reu.length >> 8;
+		module[ 13 ] = reu.IRQmask;
+		module[ 14 ] = reu.addrREUCtrl;
+		ok &= freezeWriteModule( &file, "REU1764", module, FREEZE_SIZE_REU, reuMem, reuSizeKB * 1024 );
+	}
+
+	if ( !ok )
+		logger->Write( "RAD", LogError, "Write error" );
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	return ok;
+}
@@ -0,0 +1,67 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - freezing the running C64 to a Vice snapshot (VSF)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _freeze_h
+#define _freeze_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// freezer ("FREEZE ON" in rad.cfg): holding the button for FREEZE_HOLD_MS captures the running program before the menu
+// is shown: the CPU registers are taken from an interrupt served in Ultimax mode (C64Side/ultimax_freeze.a), memory and 
+// the readable I/O registers are burst-read using DMA, and the snapshot is written in the layout that resetAndInjectVSF() restores.
+// What cannot be read back is approximated: the CIA timer latches (sampled from the running counters), the CIA interrupt
+// masks (guessed from the timers), the SID registers (only $d419-$d41c are readable) and the raster compare line (current line)
+#define FILENAME_FREEZE			"SD:RAD_PRG/FREEZE.VSF"
+#define FREEZE_HOLD_MS			1000
+#define FREEZE_IRQ_TIMEOUT		250000		// C64 cycles to wait for the CPU to take the interrupt
+
+typedef struct
+{
+	u8  a, x, y, sp, p;
+	u8  port0, port1;			// $00 (data direction) and $01 of the CPU port
+	u16 pc;
+	u16 rasterLine;
+	u8  rasterCycle;
+	u8  vic[ 0x2f ];
+	u8  cia1[ 20 ], cia2[ 20 ];	// registers $0-$c, [13] interrupt mask, [14/15] control registers, [16-19] timer latches
+	u8  sid[ 0x20 ];
+	u8  colorRAM[ 1024 ];
+	u8  ram[ 65536 ];
+} FREEZESTATE;
+
+extern u32 radFreeze;
+extern FREEZESTATE freezeState;
+
+// captures the C64 (see above), returns 0 if the CPU did not take the interrupt; afterwards the CPU is halted by DMA
+extern int freezeC64( FREEZESTATE *f );
+
+// writes the snapshot, including the REU module if reuMem != NULL
+extern int freezeWriteVSF( CLogger *logger, const char *DRIVE, const char *FILENAME, FREEZESTATE *f, u8 *reuMem, u32 reuSizeKB );
+
+#endif
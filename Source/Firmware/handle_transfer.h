@@ -26,8 +26,6 @@
 
 */
 
-//#define USE_OLD_CACHE_PRELOADING_SCHEME
-
 #define COMMON_ENTRY_IN_TRANSFER
 
 #pragma GCC diagnostic push
@@ -37,6 +35,7 @@ register u32 g2;
 
 register u16 c_a = reu.addrC64;
 register u32 r_a = (u32)reu.addrREU | ( (u32)reu.bank << 16 );
+u32 r_aStart = r_a;
 
 // don't remove any of the (seemingly) redundant reuPrefetchL1 calls in this file!
 reuPrefetchL1( r_a );
@@ -47,19 +46,18 @@ register s32 length = l;
 reu.incrC64 = reu.addrREUCtrl & REU_ADDR_FIX_C64 ? 0 : 1;
 reu.incrREU = reu.addrREUCtrl & REU_ADDR_FIX_REU ? 0 : 1;
 
-register u32 next_r_a, temp_r_a;
+// the byte loops add the C64 address increment from a register instead of loading reu.incrC64 for every byte
+register u32 incrC64 = reu.incrC64;
+
 register u8 newStatus = 0, x, y;
 
-#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-register u8 tmp;
-#endif
+// current segment of the transfer (see reuSegment), the inner loops run from l down to segEnd
+register u8 *src, *dst, *prev = reuWriteSink;
+register u32 seg, step;
+register s32 segEnd;
 
-//#define REU_PROTOCOL
-#ifdef REU_PROTOCOL
-extern REUPROT reuProtocol[ 65536 ];
-extern u32 nReuProtocol;
-REUPROT *R;
-#endif
+REUTRACEENTRY *T = 0;
+REU_TRACE_BEGIN( T, armCycleCounter, r_a, c_a )
 
 #ifdef COMMON_ENTRY_IN_TRANSFER
 
@@ -69,10 +67,18 @@ WAIT_FOR_VIC_HALFCYCLE
 RESTART_CYCLE_COUNTER
 reuPrefetchL1( r_a & ( reu.wrapAroundDRAM - 1 ) );
 
-WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA ); // 80ns after falling Phi2
+WAIT_UP_TO_CYCLE_SITE( TIMING_TRIGGER_DMA, PERF_SITE_TRIGGER_DMA ); // 80ns after falling Phi2
 CLR_GPIO( bDMA_OUT );
 #endif
 
+// only while a selected image is still being loaded (see reu_loader.h)
+if ( reuLoader.missing )
+	reuWaitForBanks( r_a, l );
+
+// only during the first moments of a fresh REU (see reu_pages.h)
+if ( reuPages.unfilled )
+	reuFillPages( r_a, l );
+
 switch ( reu.command & 3 )
 {
 case REU_COMMAND_TRANSFER_TO_REU: // stash: c64->reu
@@ -80,39 +86,37 @@ case REU_COMMAND_TRANSFER_TO_REU: // stash: c64->reu
 	WAIT_FOR_VIC_HALFCYCLE
 	RESTART_CYCLE_COUNTER
 
-#ifdef REU_PROTOCOL
-	R = &reuProtocol[ nReuProtocol ++ ];
-	R->cmdREUAddr = ( 0 << 24 ) | r_a;
-	R->c64AddrLength = ( c_a << 16 ) | l;
-#endif
-
-	WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA ); // 80ns after falling Phi2
+	WAIT_UP_TO_CYCLE_SITE( TIMING_TRIGGER_DMA, PERF_SITE_TRIGGER_DMA ); // 80ns after falling Phi2
 	CLR_GPIO( bDMA_OUT );
 #endif
 
+	// each byte is stored while reading the next one, the first store goes to the write sink
 	while ( l )
 	{
-		reuPrefetchW( r_a );
-		//emuReadByteREU_p1( g2, c_a );
-		//emuReadByteREU_p2( g2 );
-		DMA_READBYTE_P1( c_a );
-		DMA_READBYTE_P2();
-		if ( l < length )
-			reuStore( temp_r_a, x );
-		l --;
-		temp_r_a = r_a; REU_INCREMENT_ADDRESS( r_a ); 
-		reuPrefetchW( r_a + 64 ); 
-		REU_INCREMENT_C64ADDRESS( c_a );
-		//emuReadByteREU_p3( g2, x, (l==0) );
-		DMA_READBYTE_P3( x, (l==0) );
-	}
-	reuStore( temp_r_a, x );
+		seg = reuSegment( r_a, l, src, dst, step );
+		segEnd = l - seg;
 
+		while ( l > segEnd )
+		{
+			CACHE_PRELOADL1STRMW( dst );
+			//emuReadByteREU_p1( g2, c_a );
+			//emuReadByteREU_p2( g2 );
+			DMA_READBYTE_P1( c_a );
+			DMA_READBYTE_P2();
+			*prev = x;
+			l --;
+			prev = dst; dst += step;
+			CACHE_PRELOADL1STRMW( dst + 64 );
+			REU_INCREMENT_C64ADDRESS( c_a );
+			//emuReadByteREU_p3( g2, x, (l==0) );
+			DMA_READBYTE_P3( x, (l==0) );
+		}
 
-#ifdef REU_PROTOCOL
-	R->c64AddrLength = ( c_a << 16 ) | x;
-#endif
+		r_a = reuSegmentEnd( r_a, seg );
+	}
+	*prev = x;
 
+	reuDirtyPages( r_aStart, length );
 	reu.isModified = 1;
 
 /*	if ( length == 1 )
@@ -130,48 +134,42 @@ case REU_COMMAND_TRANSFER_TO_C64: // fetch: c64<-reu
 	RESTART_CYCLE_COUNTER
 	reuPrefetchL1( r_a & ( reu.wrapAroundDRAM - 1 ) );
 
-	WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA ); // 80ns after falling Phi2
+	WAIT_UP_TO_CYCLE_SITE( TIMING_TRIGGER_DMA, PERF_SITE_TRIGGER_DMA ); // 80ns after falling Phi2
 	CLR_GPIO( bDMA_OUT );
 #endif
 
 #if 1
-	if ( l == 16 && reu.isSpecial == SPECIAL_NUVIE && ( r_a & 0xffff ) == 0xf0 )
+	if ( l == 16 && ( reu.isSpecial & SPECIAL_NUVIE ) && ( r_a & 0xffff ) == 0xf0 )
 	{
 		CACHE_PRELOADL1STRM( &reuMemory[ r_a & ( reu.wrapAroundDRAM - 1 ) ] );
 		for ( int i = 0; i < 8; i++ )
 		{
-			#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-			reu.nextREUByte = reuLoad( r_a );
-			#endif
 			WAIT_FOR_CPU_HALFCYCLE
 			WAIT_FOR_VIC_HALFCYCLE
 			RESTART_CYCLE_COUNTER
 		}
-	} else
-#endif
-	{
-		#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-		reu.nextREUByte = reuLoad( r_a );
-		#endif
 	}
+#endif
 
 	while ( l )
 	{
-		next_r_a = REU_GET_NEXT_ADDRESS( r_a ); 
-		reuPrefetchL1( next_r_a );
-		l --;
-		//emuWriteByteREU_p1( g2, c_a, reu.nextREUByte );
-		#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-		DMA_WRITEBYTE_P1( c_a, reu.nextREUByte );
-		reu.nextREUByte = reuLoad( next_r_a ); 
-		#else
-		DMA_WRITEBYTE_P1( c_a, ( ( ( r_a & (reu.wrapAroundDRAM - 1) ) < reu.reuSize ) ? reuMemory[ ( r_a & (reu.wrapAroundDRAM - 1) ) ] : 0xff ) );
-		#endif
-		r_a = next_r_a; reuPrefetchL1( r_a ); reuPrefetchL1( r_a + 64 ); 
-		//emuWriteByteREU_p2( g2, (l==0) );
-		DMA_WRITEBYTE_P2( (l==0) );
-
-		REU_INCREMENT_C64ADDRESS( c_a );
+		seg = reuSegment( r_a, l, src, dst, step );
+		segEnd = l - seg;
+
+		while ( l > segEnd )
+		{
+			CACHE_PRELOADL1STRM( src + step );
+			l --;
+			//emuWriteByteREU_p1( g2, c_a, *src );
+			DMA_WRITEBYTE_P1( c_a, *src );
+			src += step; CACHE_PRELOADL1STRM( src ); CACHE_PRELOADL1STRM( src + 64 );
+			//emuWriteByteREU_p2( g2, (l==0) );
+			DMA_WRITEBYTE_P2( (l==0) );
+
+			REU_INCREMENT_C64ADDRESS( c_a );
+		}
+
+		r_a = reuSegmentEnd( r_a, seg );
 	}
 
 	reu.contiguousWrite = 0;
@@ -185,36 +183,37 @@ case REU_COMMAND_TRANSFER_SWAP: // swap: c64<->reu
 	WAIT_FOR_VIC_HALFCYCLE
 	RESTART_CYCLE_COUNTER
 
-	WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA ); 
+	WAIT_UP_TO_CYCLE_SITE( TIMING_TRIGGER_DMA, PERF_SITE_TRIGGER_DMA ); 
 	CLR_GPIO( bDMA_OUT );
 #endif
 
 	while ( l )
 	{
-		reuPrefetchL1( r_a );
-		//emuReadByteREU_p1( g2, c_a );
-		//emuReadByteREU_p2( g2 );
-		DMA_READBYTE_P1( c_a );
-		DMA_READBYTE_P2();
-		#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-		tmp = reuLoad( r_a ); 
-		#endif
-		next_r_a = REU_GET_NEXT_ADDRESS( r_a ); reuPrefetchL1( next_r_a );l --; reuPrefetchL1( r_a + 64 ); 
-		//emuReadByteREU_p3( g2, x, false );
-		DMA_READBYTE_P3( x, false );
-
-		//emuWriteByteREU_p1( g2, c_a, tmp );
-		#ifdef USE_OLD_CACHE_PRELOADING_SCHEME
-		DMA_WRITEBYTE_P1( c_a, tmp );
-		#else
-		DMA_WRITEBYTE_P1( c_a, ( ( ( r_a & (reu.wrapAroundDRAM - 1) ) < reu.reuSize ) ? reuMemory[ ( r_a & (reu.wrapAroundDRAM - 1) ) ] : 0xff ) );
-		#endif
-		{reuStore( r_a, x ); r_a = next_r_a; REU_INCREMENT_C64ADDRESS( c_a ); }
-		//emuWriteByteREU_p2( g2, (l==0) );
-		DMA_WRITEBYTE_P2( (l==0) );
+		seg = reuSegment( r_a, l, src, dst, step );
+		segEnd = l - seg;
 
+		while ( l > segEnd )
+		{
+			CACHE_PRELOADL1STRM( src );
+			//emuReadByteREU_p1( g2, c_a );
+			//emuReadByteREU_p2( g2 );
+			DMA_READBYTE_P1( c_a );
+			DMA_READBYTE_P2();
+			CACHE_PRELOADL1STRM( src + step ); l --; CACHE_PRELOADL1STRM( src + 64 );
+			//emuReadByteREU_p3( g2, x, false );
+			DMA_READBYTE_P3( x, false );
+
+			//emuWriteByteREU_p1( g2, c_a, *src );
+			DMA_WRITEBYTE_P1( c_a, *src );
+			{ *dst = x; src += step; dst += step; REU_INCREMENT_C64ADDRESS( c_a ); }
+			//emuWriteByteREU_p2( g2, (l==0) );
+			DMA_WRITEBYTE_P2( (l==0) );
+		}
+
+		r_a = reuSegmentEnd( r_a, seg );
 	}
 
+	reuDirtyPages( r_aStart, length );
 	reu.isModified = 1;
 	reu.contiguousWrite = 0;
 	++l; newStatus = REU_STATUS_END_OF_BLOCK;
@@ -226,34 +225,43 @@ case REU_COMMAND_TRANSFER_VERIFY: // verify: c64-?-reu
 	WAIT_FOR_VIC_HALFCYCLE
 	RESTART_CYCLE_COUNTER
 
-	WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA );
+	WAIT_UP_TO_CYCLE_SITE( TIMING_TRIGGER_DMA, PERF_SITE_TRIGGER_DMA );
 	CLR_GPIO( bDMA_OUT );
 #endif
 
 	reu.nextREUByte = reuLoad( r_a );
 
-	while ( l )
+	while ( l && !newStatus )
 	{
-		reuPrefetchL1( r_a );
-		emuReadByteREU_p1( g2, c_a );
-		emuReadByteREU_p2( g2 );
-		l --;
-		next_r_a = REU_GET_NEXT_ADDRESS( r_a ); reuPrefetchL1( r_a + 64 );
-		y = reuLoad( r_a );
-		r_a = next_r_a; REU_INCREMENT_C64ADDRESS( c_a ); 
-		emuReadByteREU_p3( g2, x, ( l == 0 ) );
-		if ( x != y )
-		{
-			newStatus |= REU_STATUS_VERIFY_ERROR;
+		seg = reuSegment( r_a, l, src, dst, step );
+		segEnd = l - seg;
 
-			if ( l > 1 )
+		while ( l > segEnd )
+		{
+			CACHE_PRELOADL1STRM( src );
+			emuReadByteREU_p1( g2, c_a );
+			emuReadByteREU_p2( g2 );
+			l --;
+			CACHE_PRELOADL1STRM( src + 64 );
+			y = *src; src += step;
+			REU_INCREMENT_C64ADDRESS( c_a ); 
+			emuReadByteREU_p3( g2, x, ( l == 0 ) );
+			if ( x != y )
 			{
-				WAIT_FOR_CPU_HALFCYCLE
-				WAIT_FOR_VIC_HALFCYCLE
-				RESTART_CYCLE_COUNTER
+				newStatus |= REU_STATUS_VERIFY_ERROR;
+
+				if ( l > 1 )
+				{
+					WAIT_FOR_CPU_HALFCYCLE
+					WAIT_FOR_VIC_HALFCYCLE
+					RESTART_CYCLE_COUNTER
+				}
+				break;
 			}
-			break;
 		}
+
+		// the REU address advances past a failing byte as well
+		r_a = reuSegmentEnd( r_a, seg - ( l - segEnd ) );
 	}
 
 	if ( l == 0 )
@@ -277,7 +285,7 @@ case REU_COMMAND_TRANSFER_VERIFY: // verify: c64-?-reu
 	SET_GPIO( bDMA_OUT );
 
 	// this is a hack (sort of detects REU tests) to compensate for one peculiarity in the cache preloading
-	if ( reu.contiguousWrite == reu.reuSize && ( /*reu.addrREU |*/ ( (u32)reu.bank << 16 ) ) == 0 )
+	if ( reu.contiguousWrite == reu.reuSize && ( /*reu.addrREU |*/ ( (u32)reu.bank << 16 ) ) == 0 && !( reu.isSpecial & SPECIAL_NO_VERIFY_HACK ) )
 		newStatus &= ~REU_STATUS_VERIFY_ERROR;
 
 	reu.contiguousWrite = 0;
@@ -285,7 +293,10 @@ case REU_COMMAND_TRANSFER_VERIFY: // verify: c64-?-reu
 	break;
 }
 
+REU_TRACE_END( T, newStatus )
+
 reuUpdateRegisters( c_a, r_a, l, newStatus );
+reuPrefetchAfterTransfer( r_aStart, reu.incrREU ? length : 1 );
 
 reu.command = ( reu.command & ~REU_COMMAND_EXECUTE ) | REU_COMMAND_FF00_DISABLED;
 
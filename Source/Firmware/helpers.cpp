@@ -28,6 +28,7 @@
 */
 
 #include "helpers.h"
+#include "lz_image.h"
 #include <circle/util.h>
 
 unsigned char toupper( unsigned char c )
@@ -53,26 +54,48 @@ void strupr( char *d, char *s )
 	strupr( (unsigned char*)d );
 }
 
-void makeFileStructure( const char *DRIVE )
+static FATFS fsFileSystem;
+static char fsDrive[ 16 ] = { 0 };
+
+int fsMount( const char *DRIVE )
 {
-	FATFS m_FileSystem;
+	if ( fsDrive[ 0 ] && strcmp( fsDrive, DRIVE ) == 0 )
+		return FR_OK;
 
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK ) return;
+	fsFlush();
+
+	int result = f_mount( &fsFileSystem, DRIVE, 1 );
+	if ( result == FR_OK )
+	{
+		strncpy( fsDrive, DRIVE, 15 );
+		fsDrive[ 15 ] = 0;
+	}
+	return result;
+}
+
+void fsFlush()
+{
+	if ( fsDrive[ 0 ] )
+		f_mount( 0, fsDrive, 0 );
+	fsDrive[ 0 ] = 0;
+}
+
+void makeFileStructure( const char *DRIVE )
+{
+	if ( fsMount( DRIVE ) != FR_OK ) return;
 
 	f_mkdir( "RAD_PRINT" );
 	f_chdir( "RAD_PRG" );
 	f_mkdir( "IECBuddy" );
 
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK ) return;
+	f_chdir( "/" );
 }
 
 // file reading
 int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size )
 {
-	FATFS m_FileSystem;
-
 	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+	if ( fsMount( DRIVE ) != FR_OK )
 		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
 
 	// get filesize
@@ -87,9 +110,6 @@ int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data
 	{
 		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
 
-		if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-			logger->Write( "RAD", LogPanic, "Cannot unmount drive: %s", DRIVE );
-
 		return 0;
 	}
 
@@ -104,20 +124,14 @@ int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data
 
 	if ( f_close( &file ) != FR_OK )
 		logger->Write( "RAD", LogPanic, "Cannot close file" );
-
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RAD", LogPanic, "Cannot unmount drive: %s", DRIVE );
 	
 	return 1;
 }
 
 int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *size )
 {
-	FATFS m_FileSystem;
-
 	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+	if ( fsMount( DRIVE ) != FR_OK )
 		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
 
 	// get filesize
@@ -128,10 +142,6 @@ int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *
 		return 0;
 
 	*size = (u32)info.fsize;
-
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RAD", LogPanic, "Cannot unmount drive: %s", DRIVE );
 	
 	return 1;
 }
@@ -139,10 +149,8 @@ int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *
 // file writing
 int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size )
 {
-	FATFS m_FileSystem;
-
 	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+	if ( fsMount( DRIVE ) != FR_OK )
 		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
 
 	// open file
@@ -163,11 +171,236 @@ int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *dat
 
 	if ( f_close( &file ) != FR_OK )
 		logger->Write( "RAD", LogPanic, "Cannot close file" );
-
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RAD", LogPanic, "Cannot unmount drive: %s", DRIVE );
 	
 	return 1;
 }
 
+
+// rewrites only the blocks (size 1 << blockShift) of an existing file for which blockState & mask is set,
+// returns 0 (and writes nothing) if the file does not exist or has a different size
+int writeFileBlocks( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size, const u8 *blockState, u8 mask, u32 blockShift )
+{
+	// mount file system
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	// open existing file
+	FIL file;
+	u32 result = f_open( &file, FILENAME, FA_WRITE | FA_OPEN_EXISTING );
+	if ( result != FR_OK || f_size( &file ) != size )
+	{
+		if ( result == FR_OK )
+			f_close( &file );
+
+		return 0;
+	}
+
+	// write runs of consecutive modified blocks
+	u32 nBlocks = ( size + ( 1 << blockShift ) - 1 ) >> blockShift, nWritten = 0;
+
+	for ( u32 i = 0; i < nBlocks && result == FR_OK; )
+	{
+		if ( !( blockState[ i ] & mask ) )
+		{
+			i ++;
+			continue;
+		}
+
+		u32 j = i + 1;
+		while ( j < nBlocks && ( blockState[ j ] & mask ) )
+			j ++;
+
+		u32 ofs = i << blockShift;
+		u32 len = min( j << blockShift, size ) - ofs;
+		u32 nBytesWritten;
+
+		result = f_lseek( &file, ofs );
+		if ( result == FR_OK )
+			result = f_write( &file, data + ofs, len, &nBytesWritten );
+
+		nWritten += j - i;
+		i = j;
+	}
+
+	if ( result != FR_OK )
+		logger->Write( "RAD", LogError, "Write error" );
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	logger->Write( "RAD", LogNotice, "%s: rewrote %d of %d blocks", FILENAME, nWritten, nBlocks );
+
+	return 1;
+}
+
+// compressed images are read and written block by block through this buffer
+static u8 lzBuffer[ LZIMAGE_BLOCK_SIZE ];
+static u32 lzLength[ LZIMAGE_MAX_BLOCKS ];
+
+// reads a compressed image (see lz_image.h), the time spent depends on the compressed size: all-zero blocks are not
+// stored, and not even cleared if zeroBlocks is given (zeroBlocks[ i ] = 1 for these, 0 for all others)
+int readFileLZ( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size, u8 *zeroBlocks )
+{
+	// mount file system
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	// open file
+	FIL file;
+	u32 result = f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING );
+	if ( result != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
+
+		return 0;
+	}
+
+	// header and block table
+	LZIMAGEHEADER h;
+	u32 nBytesRead;
+	result = f_read( &file, &h, sizeof( LZIMAGEHEADER ), &nBytesRead );
+
+	if ( result != FR_OK || nBytesRead != sizeof( LZIMAGEHEADER ) || h.magic != LZIMAGE_MAGIC || h.blockShift != LZIMAGE_BLOCK_SHIFT ||
+		 h.nBlocks > LZIMAGE_MAX_BLOCKS || h.size > ( h.nBlocks << LZIMAGE_BLOCK_SHIFT ) ||
+		 f_read( &file, lzLength, h.nBlocks * sizeof( u32 ), &nBytesRead ) != FR_OK || nBytesRead != h.nBlocks * sizeof( u32 ) )
+	{
+		logger->Write( "RAD", LogError, "Not a compressed image: %s", FILENAME );
+		h.nBlocks = h.size = 0;
+	}
+
+	*size = h.size;
+
+	for ( u32 i = 0; i < h.nBlocks; i++ )
+	{
+		u8 *d = &data[ i << LZIMAGE_BLOCK_SHIFT ];
+		u32 n = min( (u32)LZIMAGE_BLOCK_SIZE, h.size - ( i << LZIMAGE_BLOCK_SHIFT ) );
+
+		if ( zeroBlocks )
+			zeroBlocks[ i ] = lzLength[ i ] == 0;
+
+		if ( lzLength[ i ] == 0 )
+		{
+			if ( !zeroBlocks )
+				memset( d, 0, n );
+		} else
+		if ( lzLength[ i ] == n )
+		{
+			result = f_read( &file, d, n, &nBytesRead );
+		} else
+		{
+			if ( lzLength[ i ] > LZIMAGE_BLOCK_SIZE ||
+				 ( result = f_read( &file, lzBuffer, lzLength[ i ], &nBytesRead ) ) != FR_OK ||
+				 !lzDecompressBlock( lzBuffer, lzLength[ i ], d, n ) )
+			{
+				logger->Write( "RAD", LogError, "Corrupt block %d in %s", i, FILENAME );
+				memset( d, 0, n );
+				if ( lzLength[ i ] > LZIMAGE_BLOCK_SIZE )
+					break;
+			}
+		}
+
+		if ( result != FR_OK )
+		{
+			logger->Write( "RAD", LogError, "Read error" );
+			break;
+		}
+	}
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	return 1;
+}
+
+// writes a compressed image (see lz_image.h)
+int writeFileLZ( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size )
+{
+	// mount file system
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	// open file
+	FIL file;
+	u32 result = f_open( &file, FILENAME, FA_WRITE | FA_CREATE_ALWAYS );
+	if ( result != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
+
+		return 0;
+	}
+
+	LZIMAGEHEADER h;
+	h.magic = LZIMAGE_MAGIC;
+	h.size = size;
+	h.blockShift = LZIMAGE_BLOCK_SHIFT;
+	h.nBlocks = ( size + LZIMAGE_BLOCK_SIZE - 1 ) >> LZIMAGE_BLOCK_SHIFT;
+	memset( lzLength, 0, sizeof( lzLength ) );
+
+	// the block table is written again at the end
+	u32 nBytesWritten, compressed = 0;
+	result = f_write( &file, &h, sizeof( LZIMAGEHEADER ), &nBytesWritten );
+	if ( result == FR_OK )
+		result = f_write( &file, lzLength, h.nBlocks * sizeof( u32 ), &nBytesWritten );
+
+	for ( u32 i = 0; i < h.nBlocks && result == FR_OK; i++ )
+	{
+		u8 *d = &data[ i << LZIMAGE_BLOCK_SHIFT ];
+		u32 n = min( (u32)LZIMAGE_BLOCK_SIZE, size - ( i << LZIMAGE_BLOCK_SHIFT ) );
+
+		if ( lzIsZeroBlock( d, n ) )
+			continue;
+
+		lzLength[ i ] = lzCompressBlock( d, n, lzBuffer, n - 1 );
+		if ( lzLength[ i ] )
+			result = f_write( &file, lzBuffer, lzLength[ i ], &nBytesWritten ); else
+			result = f_write( &file, d, lzLength[ i ] = n, &nBytesWritten );
+		compressed += lzLength[ i ];
+	}
+
+	if ( result == FR_OK )
+		result = f_lseek( &file, sizeof( LZIMAGEHEADER ) );
+	if ( result == FR_OK )
+		result = f_write( &file, lzLength, h.nBlocks * sizeof( u32 ), &nBytesWritten );
+
+	if ( result != FR_OK )
+		logger->Write( "RAD", LogError, "Write error" );
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	logger->Write( "RAD", LogNotice, "%s: %d KB compressed to %d KB", FILENAME, size / 1024, compressed / 1024 );
+
+	return 1;
+}
+
+// reads the uncompressed size from the header of a compressed image
+int getFileSizeLZ( const char *FILENAME, u32 *size )
+{
+	FIL file;
+	if ( f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+		return 0;
+
+	LZIMAGEHEADER h;
+	u32 nBytesRead;
+	u32 result = f_read( &file, &h, sizeof( LZIMAGEHEADER ), &nBytesRead );
+	f_close( &file );
+
+	if ( result != FR_OK || nBytesRead != sizeof( LZIMAGEHEADER ) || h.magic != LZIMAGE_MAGIC )
+		return 0;
+
+	*size = h.size;
+	return 1;
+}
+
+// compares two file names, ignoring case and the kind of path separator
+int isSameFile( const char *a, const char *b )
+{
+	for ( ; *a && *b; a++, b++ )
+	{
+		char ca = *a == '\\' ? '/' : toupper( *a );
+		char cb = *b == '\\' ? '/' : toupper( *b );
+		if ( ca != cb )
+			return 0;
+	}
+	return *a == *b;
+}
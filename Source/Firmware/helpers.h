@@ -33,9 +33,19 @@
 #include <SDCard/emmc.h>
 #include <fatfs/ff.h>
 
+// the file system is mounted on first use and then stays mounted, such that FatFs keeps the FAT and directory sectors
+// it has read; all functions close their files again, i.e. the card is consistent at any time, fsFlush() unmounts (before rebooting)
+extern int fsMount( const char *DRIVE );
+extern void fsFlush();
+
 extern int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size );
 extern int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *size );
 extern int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size );
+extern int writeFileBlocks( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size, const u8 *blockState, u8 mask, u32 blockShift );
+extern int isSameFile( const char *a, const char *b );
+extern int readFileLZ( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size, u8 *zeroBlocks );
+extern int writeFileLZ( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size );
+extern int getFileSizeLZ( const char *FILENAME, u32 *size );
 
 #define ROMH_ACCESS			(!(g2 & bROMH))
 #define CPU_RESET			(!(g2&bRESET_OUT)) 
@@ -0,0 +1,233 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - resident cache of REU/GeoRAM images
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "helpers.h"
+#include "rad_reu.h"
+#include "reu_pages.h"
+#include "image_cache.h"
+#include "lz_image.h"
+#include "fingerprint.h"
+
+extern u8 *mempoolPtr;
+extern u8 geoDirty[];
+extern char geoImage[];
+extern u32 geoSizeKB;
+
+static IMAGECACHESLOT slot[ IMAGECACHE_SLOTS_MAX ];
+static u32 nSlots = 0, useCounter = 0;
+static s32 current = -1;
+
+void imageCacheInit( CLogger *logger, u8 *mempool, u64 heapFree )
+{
+	memset( slot, 0, sizeof( slot ) );
+	slot[ 0 ].mem = mempool;
+	nSlots = 1;
+
+	while ( nSlots < IMAGECACHE_SLOTS_MAX && heapFree >= IMAGECACHE_SLOT_SIZE + 128 + IMAGECACHE_HEAP_RESERVE )
+	{
+		u8 *m = new u8[ IMAGECACHE_SLOT_SIZE + 128 ];
+		if ( !m )
+			break;
+		slot[ nSlots ++ ].mem = (u8*)( ( (uintptr)m + 127 ) & ~(uintptr)127 );
+		heapFree -= IMAGECACHE_SLOT_SIZE + 128;
+	}
+
+	current = -1;
+	logger->Write( "RAD", LogNotice, "image cache: %d resident images", nSlots );
+}
+
+static int imageCacheStat( const char *DRIVE, const char *FILENAME, u32 *size, u32 *date, u32 *time )
+{
+	FILINFO info;
+
+	if ( fsMount( DRIVE ) != FR_OK )
+		return 0;
+
+	u32 result = f_stat( FILENAME, &info );
+
+	if ( result != FR_OK )
+		return 0;
+
+	*size = (u32)info.fsize;
+	*date = info.fdate;
+	*time = info.ftime;
+	return 1;
+}
+
+// remembers which file the memory of the current slot corresponds to, and its dirty state
+static void imageCachePark( const char *DRIVE )
+{
+	if ( current < 0 )
+		return;
+
+	IMAGECACHESLOT *s = &slot[ current ];
+	current = -1;
+
+	if ( !s->used )
+		return;
+
+	const char *image = s->type == IMAGECACHE_REU ? reuPages.image : geoImage;
+
+	// a fresh REU/GeoRAM which has never been saved is not kept
+	if ( !image[ 0 ] || !imageCacheStat( DRIVE, image, &s->fileSize, &s->fileDate, &s->fileTime ) )
+	{
+		s->used = 0;
+		return;
+	}
+
+	strncpy( s->path, image, sizeof( s->path ) - 1 );
+
+	if ( s->type == IMAGECACHE_REU )
+	{
+		memcpy( &s->pages, &reuPages, sizeof( REUPAGES ) );
+		s->modified = reuPagesCount( REU_PAGE_DIRTY ) ? 1 : 0;
+		s->memSize = reuPages.nPages << REU_PAGE_SHIFT;
+		s->isSpecial = reuImageSpecial;
+		s->fingerprint = reuImageFingerprint;
+	} else
+	{
+		s->memSize = geoSizeKB * 1024;
+		memcpy( s->geoDirty, geoDirty, IMAGECACHE_GEO_BLOCKS );
+		s->modified = 0;
+		for ( u32 i = 0; i < IMAGECACHE_GEO_BLOCKS; i++ )
+			if ( geoDirty[ i ] )
+				s->modified = 2;
+	}
+}
+
+// a modified image has to be written to its file before the slot is reused
+static void imageCacheWriteBack( CLogger *logger, const char *DRIVE, IMAGECACHESLOT *s )
+{
+	logger->Write( "RAD", LogNotice, "image cache: writing back %s", s->path );
+
+	if ( s->type == IMAGECACHE_REU )
+		reuPagesFlush( s->mem );
+
+	if ( lzIsCompressedImage( s->path ) )
+		writeFileLZ( logger, DRIVE, s->path, s->mem, s->memSize ); else
+	if ( s->type == IMAGECACHE_REU )
+	{
+		if ( !writeFileBlocks( logger, DRIVE, s->path, s->mem, s->fileSize, s->pages.state, REU_PAGE_DIRTY, REU_PAGE_SHIFT ) )
+			writeFile( logger, DRIVE, s->path, s->mem, s->fileSize );
+	} else
+	{
+		if ( !writeFileBlocks( logger, DRIVE, s->path, s->mem, s->fileSize, s->geoDirty, 1, 14 ) )
+			writeFile( logger, DRIVE, s->path, s->mem, s->fileSize );
+	}
+}
+
+u8 *imageCacheSelect( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 type, u32 *hit )
+{
+	u32 size = 0, date = 0, time = 0;
+	s32 s = -1;
+
+	imageCachePark( DRIVE );
+	*hit = 0;
+
+	if ( FILENAME && imageCacheStat( DRIVE, FILENAME, &size, &date, &time ) )
+		for ( u32 i = 0; i < nSlots; i++ )
+			if ( slot[ i ].used && slot[ i ].type == type && isSameFile( slot[ i ].path, FILENAME ) )
+			{
+				if ( slot[ i ].fileSize == size && slot[ i ].fileDate == date && slot[ i ].fileTime == time )
+				{
+					s = i;
+					*hit = 1;
+				} else
+				{
+					// the file has been replaced: the resident copy is outdated
+					if ( slot[ i ].modified )
+						logger->Write( "RAD", LogNotice, "image cache: %s changed on SD, dropping modified copy", FILENAME );
+					slot[ i ].used = 0;
+				}
+			}
+
+	// otherwise reuse an empty slot, or the least recently used one (unmodified images first)
+	if ( s < 0 )
+	{
+		for ( u32 pass = 0; pass < 2 && s < 0; pass++ )
+			for ( u32 i = 0; i < nSlots; i++ )
+				if ( !slot[ i ].used )
+				{
+					s = i;
+					break;
+				} else
+				if ( ( pass == 1 || !slot[ i ].modified ) && ( s < 0 || slot[ i ].lastUse < slot[ s ].lastUse ) )
+					s = i;
+
+		if ( slot[ s ].used && slot[ s ].modified )
+			imageCacheWriteBack( logger, DRIVE, &slot[ s ] );
+
+		slot[ s ].used = 1;
+		slot[ s ].modified = 0;
+		slot[ s ].path[ 0 ] = 0;
+	}
+
+	slot[ s ].type = type;
+	slot[ s ].lastUse = ++ useCounter;
+	current = s;
+
+	mempoolPtr = slot[ s ].mem;
+	return mempoolPtr;
+}
+
+u32 imageCacheRestore( u32 *size )
+{
+	IMAGECACHESLOT *s = &slot[ current ];
+
+	*size = s->fileSize;
+
+	if ( s->type == IMAGECACHE_REU )
+	{
+		memcpy( &reuPages, &s->pages, sizeof( REUPAGES ) );
+		reuImageSpecial = s->isSpecial;
+		reuImageFingerprint = s->fingerprint;
+	} else
+	{
+		memcpy( geoDirty, s->geoDirty, IMAGECACHE_GEO_BLOCKS );
+		strncpy( geoImage, s->path, 1023 );
+	}
+
+	return s->modified;
+}
+
+void imageCacheDiscard()
+{
+	if ( current < 0 )
+		return;
+
+	u32 modified = 0;
+	if ( slot[ current ].type == IMAGECACHE_REU )
+		modified = reuPagesCount( REU_PAGE_DIRTY ); else
+		for ( u32 i = 0; i < IMAGECACHE_GEO_BLOCKS; i++ )
+			modified |= geoDirty[ i ];
+
+	// an unmodified image can stay resident
+	if ( modified )
+		slot[ current ].used = 0;
+}
@@ -0,0 +1,78 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - resident cache of REU/GeoRAM images
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _image_cache_h
+#define _image_cache_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "reu_pages.h"
+
+// REU/GeoRAM images stay resident after the emulation has switched to another image: the memory of the REU or
+// GeoRAM is one of several slots (the first one is mempool, the others are allocated from the free heap), and
+// re-selecting an image whose file did not change (path, size and time stamp) only switches mempoolPtr;
+// a modified image stays resident with its modified pages, it is written back only if its slot has to be reused
+#define IMAGECACHE_SLOTS_MAX	8
+#define IMAGECACHE_SLOT_SIZE	( 16384 * 1024 + 8192 )
+#define IMAGECACHE_HEAP_RESERVE	( 64 * 1024 * 1024 )	// heap left for everything else
+#define IMAGECACHE_GEO_BLOCKS	( 4096 / 16 )
+
+#define IMAGECACHE_REU			0
+#define IMAGECACHE_GEORAM		1
+
+typedef struct
+{
+	u8  *mem;
+	u32 used, type;
+	u32 modified, isSpecial, fingerprint;
+
+	// key: the file this slot holds (as it has been when the emulation switched away from it)
+	char path[ 1024 ];
+	u32 fileSize, fileDate, fileTime;
+	u32 memSize;
+	u32 lastUse;
+
+	// dirty state of the image
+	REUPAGES pages;
+	u8  geoDirty[ IMAGECACHE_GEO_BLOCKS ];
+} IMAGECACHESLOT;
+
+extern void imageCacheInit( CLogger *logger, u8 *mempool, u64 heapFree );
+
+// returns the memory for the next emulation (and sets mempoolPtr to it), *hit = 1 if FILENAME is resident;
+// the image the emulation ran with before is parked in its slot
+extern u8 *imageCacheSelect( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 type, u32 *hit );
+
+// after a hit and initREU()/geoRAM_Init(): restores the page state, returns the modified flag (reu.isModified)
+// and the size of the image file
+extern u32 imageCacheRestore( u32 *size );
+
+// the menu dropped the current image (unmount, different type or size): if it has been modified, it is not kept
+extern void imageCacheDiscard();
+
+#endif
@@ -57,6 +57,9 @@ u32 TIMING_RW_BEFORE_ADDR = 40;
 // initialize what we need for the performance counters
 void initCycleCounter()
 {
+#ifdef RAD_HOST_SIMULATION
+	RESET_CPU_CYCLE_COUNTER
+#else
 	unsigned long rControl;
 	unsigned long rFilter;
 	unsigned long rEnableSet;
@@ -79,6 +82,7 @@ void initCycleCounter()
 	rControl = ( 1 << PMCR_LC_EN_BIT ) | ( 1 << PMCR_C_RESET_BIT ) | ( 1 << PMCR_EN_BIT );
 	asm volatile( "msr PMCR_EL0, %0" : : "r" ( rControl ) );
 	asm volatile( "mrs %0, PMCR_EL0" : "=r" ( rControl ) );
+#endif
 }
 
 void setDefaultTimings( int mode )
@@ -110,6 +114,7 @@ void setDefaultTimings( int mode )
 	}
 }
 
+#ifndef RAD_HOST_SIMULATION
 __attribute__( ( always_inline ) ) inline void LDNP_2x32( unsigned long addr, u32 &val1, u32 &val2 )
 {
     __asm__ __volatile__("ldnp %0, %1, [%2]\n\t" : "=r" (val1), "=r" (val2) : "r" (addr) : "memory");
@@ -135,3 +140,4 @@ __attribute__( ( always_inline ) ) inline u16 LDNP_1x16( unsigned long addr )
     __asm__ __volatile__("ldnp %0, %1, [%2]\n\t" : "=r" (val1), "=r" (val2) : "r" ((unsigned long)addr) : "memory");
 	return val1 & 255;
 }*/
+#endif
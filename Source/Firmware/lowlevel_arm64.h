@@ -78,6 +78,11 @@ extern u32 hasSIDKick;
 #define AA __attribute__ ((aligned (64)))
 #define AAA __attribute__ ((aligned (128)))
 
+#ifdef RAD_HOST_SIMULATION
+// host build (Source/Host): cycle counter and cache hints are provided by the simulated bus
+#include "sim_lowlevel.h"
+#else
+
 #define BEGIN_CYCLE_COUNTER \
 						  		armCycleCounter = 0; \
 								asm volatile( "MRS %0, PMCCNTR_EL0" : "=r" (armCycleCounter) );
@@ -120,6 +125,20 @@ extern u32 hasSIDKick;
 #define CACHE_PRELOADI( ptr )		{ asm volatile ("prfm PLIL1STRM, [%0]" :: "r" (ptr)); }
 #define CACHE_PRELOADIKEEP( ptr )	{ asm volatile ("prfm PLIL1KEEP, [%0]" :: "r" (ptr)); }
 
+// zeroes a (64 byte) cache line without reading it from memory first
+#define CACHE_ZEROLINE( ptr )		{ asm volatile ("dc zva, %0" :: "r" (ptr) : "memory"); }
+
+// ordering of memory accesses between cores, and waking up a core sleeping in WFE
+#define MEMORY_BARRIER				{ asm volatile ("dmb ish" ::: "memory"); }
+#define DATA_SYNC_BARRIER			{ asm volatile ("dsb ish" ::: "memory"); }
+#define SIGNAL_EVENT				{ asm volatile ("dsb ish\n\tsev" ::: "memory"); }
+#define WAIT_FOR_EVENT				{ asm volatile ("wfe" ::: "memory"); }
+
+// bit reversal for the address latches, and register pinning for the DMA macros
+#define RBIT32( x )					asm volatile( "rbit %w0, %w1" : "=r" ( x ) : "r" ( x ) );
+#define ASM_REG( r )				asm( r )
+#endif
+
 #define CACHE_PRELOAD_INSTRUCTION_CACHE( p, size )			\
 	{ u8 *ptr = (u8*)( p );									\
 	for ( register u32 i = 0; i < (size+63) / 64; i++ )	{	\
@@ -186,6 +205,7 @@ extern u32 hasSIDKick;
 		forceRead = ptr32[ seed % ( size / 4 ) ];			\
 	} }
 
+#ifndef RAD_HOST_SIMULATION
 #define _LDNP_2x32( addr, val1, val2 ) {						\
     __asm__ __volatile__("ldnp %0, %1, [%2]\n\t" : "=r" (val1), "=r" (val2) : "r" (addr) : "memory" ); }
 
@@ -197,6 +217,7 @@ extern u32 hasSIDKick;
 
 #define _LDNP_1x8( addr, val ) { u32 tmp1, tmp2;					\
     __asm__ __volatile__("ldnp %0, %1, [%2]\n\t" : "=r" (tmp1), "=r" (tmp2) : "r" (addr) : "memory" ); val = tmp1 & 255; }
+#endif
 
 #define SET_GPIO( set )	write32( ARM_GPIO_GPSET0, (set) );
 #define CLR_GPIO( clr )	write32( ARM_GPIO_GPCLR0, (clr) );
@@ -205,6 +226,7 @@ extern u32 hasSIDKick;
 
 extern void initCycleCounter();
 
+#ifndef RAD_HOST_SIMULATION
 #define RESET_CPU_CYCLE_COUNTER \
 	asm volatile( "msr PMCR_EL0, %0" : : "r" ( ( 1 << PMCR_LC_EN_BIT ) | ( 1 << PMCR_C_RESET_BIT ) | ( 1 << PMCR_EN_BIT ) ) ); 
 
@@ -218,7 +240,12 @@ __attribute__( ( always_inline ) ) inline u8 LDNP_1x8( void *addr )
     __asm__ __volatile__("ldnp %0, %1, [%2]\n\t" : "=r" (val1), "=r" (val2) : "r" ((unsigned long)addr) : "memory");
 	return val1 & 255;
 }
+#endif
+
+// records the slack of the deadlines in the REU polling loop, dumped to SD:RAD/perf.bin when entering the menu
+//#define PERF_HEADROOM
 
+#include "perf_headroom.h"
 
 #endif
 
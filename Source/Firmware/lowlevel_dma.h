@@ -36,12 +36,6 @@
 #endif
 
 
-typedef struct
-{
-	u32 cmdREUAddr,
-		c64AddrLength;
-}REUPROT;
-
 #define DELAY(rounds) \
 	for ( int i = 0; i < rounds; i++ ) { \
 		asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" );	asm volatile( "nop" ); }
@@ -183,9 +177,9 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 
 #define DMA_READBYTE_P1( addr )	{										\
-	register u32 A asm ("r3" ) = addr;									\
-	register u32 DD asm ("r4" );										\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	register u32 A ASM_REG( "r3" ) = addr;									\
+	register u32 DD ASM_REG( "r4" );										\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD | bRW_OUT | bDIR_Dx );			\
@@ -203,7 +197,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 	CLR_GPIO( bOE_Dx );													\
 	OUT_GPIO_RW(); 														\
 																		\
-	WAIT_UP_TO_CYCLE( reu.TIMING_ENABLE_ADDRLATCH );					\
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_ENABLE_ADDRLATCH, PERF_SITE_DMA_P1 );	\
 																		\
 	g2 = read32( ARM_GPIO_GPLEV0 );										\
 	if ( VIC_BA ) {														\
@@ -229,9 +223,9 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 
 #define DMA_READBYTE_P1_CPU( addr )	{									\
-	register u32 A asm ("r3" ) = addr;									\
-	register u32 DD asm ("r4" );										\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	register u32 A ASM_REG( "r3" ) = addr;									\
+	register u32 DD ASM_REG( "r4" );										\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD | bRW_OUT | bDIR_Dx );			\
@@ -272,7 +266,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #define DMA_READBYTE_P3( x, releaseDMA ) {								\
-	WAIT_UP_TO_CYCLE( WAIT_CYCLE_WRITEDATA + 20 );						\
+	WAIT_UP_TO_CYCLE_SITE( WAIT_CYCLE_WRITEDATA + 20, PERF_SITE_DMA_P3 );	\
 	g2 = read32( ARM_GPIO_GPLEV0 );										\
 	x = (u8)( ( g2 >> D0 ) & 255 );										\
 	WAIT_FOR_VIC_HALFCYCLE												\
@@ -291,7 +285,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 #define DMA_WRITEBYTE_P1x( addr, data )	{								\
 	register u32 A = addr, DD;											\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );								\
@@ -334,7 +328,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 #define DMA_WRITEBYTE_P1( addr, data )	{								\
 	register u32 A = addr, DD;											\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );								\
@@ -348,7 +342,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 	CLR_GPIO( bLATCH_A0 | bDIR_Dx );									\
 	OUT_GPIO( RW_OUT );													\
 																		\
-	WAIT_UP_TO_CYCLE( reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING + 0 );	\
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING + 0, PERF_SITE_DMA_P1 );	\
 																		\
 	if ( VIC_BA ) {														\
 		do {															\
@@ -377,7 +371,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 #define DMA_WRITEBYTE_P1_EARLY_BA( addr, data )	{						\
 	register u32 A = addr, DD;											\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );								\
@@ -425,7 +419,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 #define DMA_WRITEBYTE_P1_IO( addr, data, pullGAMEforIO )	{			\
 	register u32 A = addr, DD;											\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );								\
@@ -455,7 +449,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 
 #define DMA_WRITEBYTE_P1_IO_CHECK_BA( addr, data, pullGAMEforIO )	{	\
 	register u32 A = addr, DD;											\
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );			\
+	RBIT32( A )														\
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );								\
 																		\
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );								\
@@ -502,7 +496,7 @@ __attribute__( ( always_inline ) ) inline u8 flipByte( u8 x )
 #define DMA_WRITEBYTE_P2( releaseDMA ) {								\
 	WAIT_FOR_VIC_HALFCYCLE												\
 	RESTART_CYCLE_COUNTER												\
-	WAIT_UP_TO_CYCLE( reu.TIMING_DATA_HOLD );							\
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_DATA_HOLD, PERF_SITE_DMA_P2 );	\
 	DISABLE_ADDRESS_LATCH_AND_BUSTRANSCEIVER( releaseDMA ) }			
 
 
@@ -555,9 +549,9 @@ void emuReadByteREU_p1( register u32 &g2, u16 addr )
 	WAIT_UP_TO_CYCLE( reu.TIMING_ENABLE_ADDRLATCH );	
 	CLR_GPIO( bLATCH_A_OE );
 #else
-	register u32 A asm ("r3" ) = addr;
-	register u32 DD asm ("r4" );
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );	// flip all bits in 32-bit-DWORD
+	register u32 A ASM_REG( "r3" ) = addr;
+	register u32 DD ASM_REG( "r4" );
+	RBIT32( A )	// flip all bits in 32-bit-DWORD
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );
 
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD | bRW_OUT | bDIR_Dx );
@@ -575,7 +569,7 @@ void emuReadByteREU_p1( register u32 &g2, u16 addr )
 	CLR_GPIO( bOE_Dx );
 	OUT_GPIO_RW(); 
 
-	WAIT_UP_TO_CYCLE( reu.TIMING_ENABLE_ADDRLATCH );	
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_ENABLE_ADDRLATCH, PERF_SITE_DMA_P1 );
 
 	if ( VIC_BA ) {											
 		do {												
@@ -616,7 +610,7 @@ void emuReadByteREU_p3( register u32 &g2, register u8 &x, bool releaseDMA )
 	RESTART_CYCLE_COUNTER
 	DISABLE_ADDRESS_LATCH_AND_BUSTRANSCEIVER( releaseDMA );
 #else
-	WAIT_UP_TO_CYCLE( WAIT_CYCLE_WRITEDATA + 20 );
+	WAIT_UP_TO_CYCLE_SITE( WAIT_CYCLE_WRITEDATA + 20, PERF_SITE_DMA_P3 );
 	g2 = read32( ARM_GPIO_GPLEV0 );
 	x = (u8)( ( g2 >> D0 ) & 255 );
 
@@ -632,9 +626,9 @@ __attribute__( ( always_inline ) ) inline
 void emuWriteByteREU_p1( register u32 &g2, u16 addr, u8 data )
 {
 #ifdef OLD_BUS_PROTOCOL_WRITE
-	register u32 A asm ("r3" ) = addr;
-	register u32 DD asm ("r4" );
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );	// flip all bits in 32-bit-DWORD
+	register u32 A ASM_REG( "r3" ) = addr;
+	register u32 DD ASM_REG( "r4" );
+	RBIT32( A )	// flip all bits in 32-bit-DWORD
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );
 
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );
@@ -662,7 +656,7 @@ void emuWriteByteREU_p1( register u32 &g2, u16 addr, u8 data )
 #else
 	register u32 A = addr;
 	register u32 DD;
-	asm volatile( "rbit %w0, %w1" : "=r" ( A ) : "r" ( A ) );	// flip all bits in 32-bit-DWORD
+	RBIT32( A )	// flip all bits in 32-bit-DWORD
 	DD = ( A & 0x00ff0000 ) << ( D0 - 16 );
 
 	SET_GPIO( bLATCH_A0 | bLATCH_A8 | DD );
@@ -675,7 +669,7 @@ void emuWriteByteREU_p1( register u32 &g2, u16 addr, u8 data )
 	CLR_GPIO( bLATCH_A0 | bDIR_Dx );
 	OUT_GPIO( RW_OUT );
 
-	WAIT_UP_TO_CYCLE( reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING );
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING, PERF_SITE_DMA_P1 );
 
 	if ( VIC_BA ) {											
 		do {												
@@ -703,7 +697,7 @@ void emuWriteByteREU_p2( register u32 &g2, bool releaseDMA )
 {
 	WAIT_FOR_VIC_HALFCYCLE
 	RESTART_CYCLE_COUNTER
-	WAIT_UP_TO_CYCLE( reu.TIMING_DATA_HOLD );
+	WAIT_UP_TO_CYCLE_SITE( reu.TIMING_DATA_HOLD, PERF_SITE_DMA_P2 );
 	DISABLE_ADDRESS_LATCH_AND_BUSTRANSCEIVER( releaseDMA )
 }
 
@@ -0,0 +1,176 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - compressed REU/GeoRAM images (.reuz/.georamz): block-wise LZ compression
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include <circle/util.h>
+#include "lz_image.h"
+
+static u32 lzHash[ 1 << LZ_HASH_BITS ];
+
+static inline u32 lzRead32( const u8 *p )
+{
+	u32 v;
+	memcpy( &v, p, 4 );
+	return v;
+}
+
+static inline u32 lzPutLength( u8 *dst, u32 op, u32 len )
+{
+	for ( ; len >= 255; len -= 255 )
+		dst[ op ++ ] = 255;
+	dst[ op ++ ] = len;
+	return op;
+}
+
+// compresses n (<= 64k) bytes, returns the compressed size or 0 if it would not fit into 'capacity' bytes
+u32 lzCompressBlock( const u8 *src, u32 n, u8 *dst, u32 capacity )
+{
+	u32 ip = 0, anchor = 0, op = 0;
+
+	memset( lzHash, 0xff, sizeof( lzHash ) );
+
+	while ( ip + LZ_MIN_MATCH <= n )
+	{
+		u32 seq = lzRead32( &src[ ip ] );
+		u32 h = ( seq * 2654435761u ) >> ( 32 - LZ_HASH_BITS );
+		u32 ref = lzHash[ h ];
+		lzHash[ h ] = ip;
+
+		if ( ref == 0xffffffff || ip - ref > 0xffff || lzRead32( &src[ ref ] ) != seq )
+		{
+			ip ++;
+			continue;
+		}
+
+		u32 len = LZ_MIN_MATCH;
+		while ( ip + len < n && src[ ref + len ] == src[ ip + len ] )
+			len ++;
+
+		// token, literal length, literals, offset, match length (worst case)
+		u32 lit = ip - anchor;
+		if ( op + 1 + lit / 255 + 1 + lit + 2 + len / 255 + 1 > capacity )
+			return 0;
+
+		u8 *token = &dst[ op ++ ];
+		*token = ( lit >= 15 ? 15 : lit ) << 4 | ( len - LZ_MIN_MATCH >= 15 ? 15 : len - LZ_MIN_MATCH );
+		if ( lit >= 15 )
+			op = lzPutLength( dst, op, lit - 15 );
+		memcpy( &dst[ op ], &src[ anchor ], lit );
+		op += lit;
+
+		dst[ op ++ ] = ( ip - ref ) & 255;
+		dst[ op ++ ] = ( ip - ref ) >> 8;
+		if ( len - LZ_MIN_MATCH >= 15 )
+			op = lzPutLength( dst, op, len - LZ_MIN_MATCH - 15 );
+
+		ip += len;
+		anchor = ip;
+	}
+
+	// trailing literals
+	u32 lit = n - anchor;
+	if ( op + 1 + lit / 255 + 1 + lit > capacity )
+		return 0;
+
+	dst[ op ++ ] = ( lit >= 15 ? 15 : lit ) << 4;
+	if ( lit >= 15 )
+		op = lzPutLength( dst, op, lit - 15 );
+	memcpy( &dst[ op ], &src[ anchor ], lit );
+
+	return op + lit;
+}
+
+// returns 1 if the compressed data decodes to exactly n bytes
+u32 lzDecompressBlock( const u8 *src, u32 length, u8 *dst, u32 n )
+{
+	u32 ip = 0, op = 0, b;
+
+	while ( ip < length )
+	{
+		u8 token = src[ ip ++ ];
+
+		u32 lit = token >> 4;
+		if ( lit == 15 )
+			do {
+				if ( ip >= length ) return 0;
+				b = src[ ip ++ ];
+				lit += b;
+			} while ( b == 255 );
+
+		if ( ip + lit > length || op + lit > n )
+			return 0;
+		memcpy( &dst[ op ], &src[ ip ], lit );
+		ip += lit; op += lit;
+
+		// last sequence
+		if ( ip == length )
+			break;
+
+		if ( ip + 2 > length )
+			return 0;
+		u32 ofs = src[ ip ] | ( src[ ip + 1 ] << 8 );
+		ip += 2;
+
+		u32 len = ( token & 15 ) + LZ_MIN_MATCH;
+		if ( ( token & 15 ) == 15 )
+			do {
+				if ( ip >= length ) return 0;
+				b = src[ ip ++ ];
+				len += b;
+			} while ( b == 255 );
+
+		if ( ofs == 0 || ofs > op || op + len > n )
+			return 0;
+
+		u8 *d = &dst[ op ], *m = d - ofs;
+		if ( ofs >= len )
+			memcpy( d, m, len ); else
+			for ( u32 i = 0; i < len; i++ )
+				d[ i ] = m[ i ];
+		op += len;
+	}
+
+	return op == n;
+}
+
+u32 lzIsZeroBlock( const u8 *src, u32 n )
+{
+	const u64 *p = (const u64 *)src;
+	for ( u32 i = 0; i < n / 8; i++ )
+		if ( p[ i ] ) return 0;
+	for ( u32 i = n & ~7; i < n; i++ )
+		if ( src[ i ] ) return 0;
+	return 1;
+}
+
+u32 lzIsCompressedImage( const char *filename )
+{
+	u32 l = strlen( filename );
+	return ( l > 5 && strcasecmp( &filename[ l - 5 ], ".reuz" ) == 0 ) ||
+		   ( l > 8 && strcasecmp( &filename[ l - 8 ], ".georamz" ) == 0 );
+}
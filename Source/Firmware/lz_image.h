@@ -0,0 +1,61 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - compressed REU/GeoRAM images (.reuz/.georamz): block-wise LZ compression
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _lz_image_h
+#define _lz_image_h
+
+#include <circle/types.h>
+
+// file layout: header, u32 length[ nBlocks ], then the blocks in order; a block length of 0 denotes an all-zero
+// block (nothing stored), the full block size an uncompressed block, anything else an LZ-compressed one
+#define LZIMAGE_MAGIC			0x5a444152	// "RADZ"
+#define LZIMAGE_BLOCK_SHIFT		16
+#define LZIMAGE_BLOCK_SIZE		( 1 << LZIMAGE_BLOCK_SHIFT )
+#define LZIMAGE_MAX_BLOCKS		( 16384 * 1024 / LZIMAGE_BLOCK_SIZE )
+
+typedef struct
+{
+	u32 magic;
+	u32 size;			// uncompressed size in bytes
+	u32 blockShift;
+	u32 nBlocks;
+} LZIMAGEHEADER;
+
+// LZ4-like sequences: token (literal length << 4 | match length - 4, 15 = more length bytes follow),
+// literals, 16-bit match offset (little endian); the last sequence consists of literals only
+#define LZ_MIN_MATCH			4
+#define LZ_HASH_BITS			12
+
+extern u32 lzCompressBlock( const u8 *src, u32 n, u8 *dst, u32 capacity );
+extern u32 lzDecompressBlock( const u8 *src, u32 length, u8 *dst, u32 n );
+extern u32 lzIsZeroBlock( const u8 *src, u32 n );
+
+// .reuz or .georamz
+extern u32 lzIsCompressedImage( const char *filename );
+
+#endif
@@ -0,0 +1,68 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - optional instrumentation: slack histograms of the WAIT_UP_TO_CYCLE deadlines in the REU polling loop
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "lowlevel_arm64.h"
+#include "helpers.h"
+
+#ifdef PERF_HEADROOM
+
+static const char FILENAME_PERF[] = "SD:RAD/perf.bin";
+
+// small enough (~2.2kb) to stay in L1 next to the REU state
+PERFHEADROOM perfHeadroom AA;
+
+void perfHeadroomReset()
+{
+	memset( &perfHeadroom, 0, sizeof( PERFHEADROOM ) );
+	perfHeadroom.magic = PERF_MAGIC;
+	perfHeadroom.version = PERF_VERSION;
+	perfHeadroom.nSites = PERF_SITES;
+	perfHeadroom.nBins = PERF_BINS;
+	perfHeadroom.binShift = PERF_BIN_SHIFT;
+	for ( u32 i = 0; i < PERF_SITES; i++ )
+		perfHeadroom.minSlack[ i ] = 0x7fffffff;
+}
+
+// called when entering the menu, writes nothing if the REU emulation did not run since the last dump
+void perfHeadroomDump( CLogger *logger, const char *DRIVE, u32 armMHz )
+{
+	u32 total = 0;
+	for ( u32 i = 0; i < PERF_SITES; i++ )
+		total += perfHeadroom.count[ i ];
+
+	if ( perfHeadroom.magic != PERF_MAGIC || total == 0 )
+		return;
+
+	perfHeadroom.armMHz = armMHz;
+	writeFile( logger, DRIVE, FILENAME_PERF, (u8*)&perfHeadroom, sizeof( PERFHEADROOM ) );
+
+	perfHeadroomReset();
+}
+
+#endif
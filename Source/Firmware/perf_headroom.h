@@ -0,0 +1,101 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - optional instrumentation: slack histograms of the WAIT_UP_TO_CYCLE deadlines in the REU polling loop
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _perf_headroom_h
+#define _perf_headroom_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// call sites of WAIT_UP_TO_CYCLE_SITE
+#define PERF_SITE_SIGNALS		0		// signals after falling Phi2 (IO2, RW, BA, ...)
+#define PERF_SITE_MULTIPLEXER	1		// address lines A0-A7 via multiplexer
+#define PERF_SITE_WRITEDATA		2		// data of a CPU write to the REU registers
+#define PERF_SITE_READ2			3		// data of a CPU read from the REU registers put on the bus
+#define PERF_SITE_TRIGGER_DMA	4		// DMA line pulled after the register write
+#define PERF_SITE_DMA_P1		5		// address latches enabled (DMA read and write)
+#define PERF_SITE_DMA_P2		6		// data hold after a DMA write
+#define PERF_SITE_DMA_P3		7		// data sampled during a DMA read
+#define PERF_SITES				8
+
+// histogram: 64 bins of 16 ARM cycles each, the last bin also counts everything beyond
+#define PERF_BINS				64
+#define PERF_BIN_SHIFT			4
+
+#define PERF_MAGIC				0x46524550	// "PERF"
+#define PERF_VERSION			1
+
+typedef struct
+{
+	u32 magic, version;
+	u32 nSites, nBins, binShift;
+	u32 armMHz;
+	u32 count[ PERF_SITES ];			// number of waits
+	u32 late[ PERF_SITES ];				// number of waits where the deadline had already passed
+	s32 minSlack[ PERF_SITES ];			// smallest slack seen (negative = cycles too late)
+	u32 hist[ PERF_SITES ][ PERF_BINS ];
+} PERFHEADROOM;
+
+#ifdef PERF_HEADROOM
+
+extern PERFHEADROOM perfHeadroom;
+
+extern void perfHeadroomReset();
+extern void perfHeadroomDump( CLogger *logger, const char *DRIVE, u32 armMHz );
+
+__attribute__( ( always_inline ) ) inline void perfRecordSlack( u32 site, s64 slack )
+{
+	perfHeadroom.count[ site ] ++;
+	if ( slack < perfHeadroom.minSlack[ site ] )
+		perfHeadroom.minSlack[ site ] = (s32)slack;
+	if ( slack < 0 )
+	{
+		perfHeadroom.late[ site ] ++;
+		return;
+	}
+	u64 bin = (u64)slack >> PERF_BIN_SHIFT;
+	if ( bin >= PERF_BINS ) bin = PERF_BINS - 1;
+	perfHeadroom.hist[ site ][ bin ] ++;
+}
+
+// one additional cycle counter read before the actual wait, the slack is measured on arrival
+// (a deadline of 0 cycles, e.g. TIMING_TRIGGER_DMA with some timings, is not recorded)
+#define WAIT_UP_TO_CYCLE_SITE( wc, site ) { 							\
+	u64 ccPerf;															\
+	READ_CYCLE_COUNTER( ccPerf )										\
+	if ( (wc) != 0 )													\
+		perfRecordSlack( site, (s64)( (wc) + armCycleCounter ) - (s64)ccPerf ); \
+	WAIT_UP_TO_CYCLE( wc ); }
+
+#else
+
+#define WAIT_UP_TO_CYCLE_SITE( wc, site ) WAIT_UP_TO_CYCLE( wc )
+
+#endif
+
+#endif
@@ -52,6 +52,10 @@ typedef struct
 
 volatile static GEOSTATE geo AAA;
 
+// 16 KB blocks written since the image has been loaded or saved, and this image (empty for a fresh GeoRAM)
+u8 geoDirty[ MAX_GEORAM_SIZE / 16 ];
+char geoImage[ 1024 ];
+
 // geoRAM memory pool 
 extern u8* mempoolPtr;
 static u8  *geoRAM_Pool = (u8*)mempoolPtr;
@@ -59,12 +63,16 @@ static u8  *geoRAM_Pool = (u8*)mempoolPtr;
 // u8* to current window
 #define GEORAM_WINDOW (&geo.RAM[ ( geo.reg[ 1 ] * 16384 ) + ( geo.reg[ 0 ] * 256 ) ])
 
-// geoRAM helper routines
-static void geoRAM_Init()
+// geoRAM helper routines (the memory is kept when switching back to a resident image, see image_cache.h)
+static void geoRAM_Init( u32 keepMemory = 0 )
 {
 	geo.reg[ 0 ] = geo.reg[ 1 ] = 0;
+	geoRAM_Pool = mempoolPtr;
 	geo.RAM = &geoRAM_Pool[0]; //(u8*)( ( (u64)&geoRAM_Pool[0] + 128 ) & ~127 );
-	memset( geo.RAM, 0, geoSizeKB * 1024 );
+	if ( !keepMemory )
+		memset( geo.RAM, 0, geoSizeKB * 1024 );
+	memset( geoDirty, 0, sizeof( geoDirty ) );
+	geoImage[ 0 ] = 0;
 
 	geo.c64CycleCount = 0;
 	geo.resetCounter = 0;
@@ -142,6 +150,7 @@ void geoRAMUsingPolling()
 				{
 					// GeoRAM write to memory page
 					GEORAM_WINDOW[ GET_IO12_ADDRESS ] = D; 
+					geoDirty[ geo.reg[ 1 ] ] = 1;
 					geo.isModified = 2;
 				} else
 				{
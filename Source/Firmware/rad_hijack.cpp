@@ -27,6 +27,10 @@
 */
 #include "rad_hijack.h"
 #include "rad_reu.h"
+#include "reu_pages.h"
+#include "image_cache.h"
+#include "lz_image.h"
+#include "config.h"
 #include "dirscan.h"
 #include "linux/kernel.h"
 #include <circle/machineinfo.h>
@@ -155,6 +159,73 @@ void NOP( u32 nCycles )
 	WAIT_FOR_VIC_HALFCYCLE		\
 	RESTART_CYCLE_COUNTER }
 
+// writes n bytes to consecutive addresses, one byte per cycle after a single resync (a write stalls while BA is low, 
+// like every POKE); with verify the block is read back and bytes which did not arrive are written again (at most 
+// POKE_BURST_PASSES times, each pass only re-reads the range between the first and last byte rewritten before),
+// returns the number of bytes rewritten in the last pass (0 = all bytes verified)
+// verify: bit k set = $k000-$kfff reads back as RAM; other addresses are not read (ROM, I/O, e.g. CIA ICRs)
+#define POKE_BURST_PASSES	3
+
+#define POKE_BURST_VERIFY_ALL			0xffff
+#define POKE_BURST_VERIFY_C64_BASIC		0x13ff		// $01 = $37: BASIC, KERNAL and I/O instead of RAM
+#define POKE_BURST_VERIFY_C128_BASIC	0x000f		// bank 15: only $0000-$3fff is RAM
+
+#define POKE_BURST_BODY( POKE_OP, PEEK_OP ) {								\
+	u32 g2, left = 0, from = 0, to = n;										\
+	BUS_RESYNC																\
+	for ( u32 i = 0; i < n; i++ )											\
+	{																		\
+		CACHE_PRELOADL1STRM( &src[ i + 64 ] );								\
+		POKE_OP( (u16)( a + i ), src[ i ] );								\
+	}																		\
+	for ( u32 pass = 0; verify && pass < POKE_BURST_PASSES; pass++ )		\
+	{																		\
+		u32 first = n, last = 0;											\
+		left = 0;															\
+		for ( u32 i = from; i < to; i++ )									\
+		{																	\
+			u8 v;															\
+			if ( !( verify & ( 1 << ( (u16)( a + i ) >> 12 ) ) ) )			\
+				continue;													\
+			CACHE_PRELOADL1STRM( &src[ i + 64 ] );							\
+			PEEK_OP( (u16)( a + i ), v );									\
+			if ( v != src[ i ] )											\
+			{																\
+				POKE_OP( (u16)( a + i ), src[ i ] );						\
+				left ++;													\
+				first = min( first, i ); last = i;							\
+			}																\
+		}																	\
+		if ( !left ) break;													\
+		from = first; to = last + 1;										\
+	}																		\
+	return left; }
+
+u32 POKE_BURST( u16 a, u32 n, const u8 *src, u32 verify )
+POKE_BURST_BODY( POKE, PEEK )
+
+// GAME is not touched (e.g. in Ultimax mode)
+u32 POKE_BURST_NG( u16 a, u32 n, const u8 *src, u32 verify )
+POKE_BURST_BODY( POKE_NG, PEEK_NG )
+
+// reads n bytes from consecutive addresses, one byte per cycle after a single resync (a read stalls while BA is low,
+// i.e. badlines and sprite fetches only delay the burst)
+#define PEEK_BURST_BODY( PEEK_OP ) {										\
+	u32 g2;																	\
+	BUS_RESYNC																\
+	for ( u32 i = 0; i < n; i++ )											\
+	{																		\
+		CACHE_PRELOADL1STRMW( &dst[ i + 64 ] );								\
+		PEEK_OP( (u16)( a + i ), dst[ i ] );								\
+	}																		}
+
+void PEEK_BURST( u16 a, u32 n, u8 *dst )
+PEEK_BURST_BODY( PEEK )
+
+// GAME is not touched (e.g. in Ultimax mode)
+void PEEK_BURST_NG( u16 a, u32 n, u8 *dst )
+PEEK_BURST_BODY( PEEK_NG )
+
 u8 detectSID()
 {
 	u8 y;
@@ -689,13 +760,9 @@ void injectAndStartPRG( u8 *prg, u32 prgSize, bool holdDMA )
 	waitAndHijack( g2 );
 
 	// now we are after the badline and DMA is asserted => we have control over the bus
-	for ( int i = 0; i < (int)prgSize - 2; i++ ) 
-	{
-		CACHE_PRELOADL2STRM( &prg[ i + 1 ] );
-		u8 d = ( (u8*)( &prg[ 2 ] ) )[ i ];
-		SPOKE( addr + i, d );
-		SPOKE( addr + i, d );
-	}
+	// (verified instead of writing every byte twice)
+	if ( prgSize > 2 )
+		POKE_BURST( addr, prgSize - 2, &prg[ 2 ], isC128 ? POKE_BURST_VERIFY_C128_BASIC : POKE_BURST_VERIFY_C64_BASIC );
 
 	u8 bgColor, cursorColor;
 	SPEEK( 0xd021, bgColor );
@@ -1369,7 +1436,7 @@ u32 readKeyRenderMenu( int fade )
 							foRenaming = 0;
 							char tmp[ 128 ];
 							sprintf( tmp, "%s%s", imageNameStr, imageNameExt );
-							if ( strcmp( (char*)pFileToRename->filename, tmp ) == 0 && ( pFileToRename->fileOp & REUDIR_FILEOP_RENAME ) )
+							if ( strcmp( DIRENTRY_FILENAME( pFileToRename ), tmp ) == 0 && ( pFileToRename->fileOp & REUDIR_FILEOP_RENAME ) )
 							{
 								if ( nFileOpsPending ) nFileOpsPending --;
 								pFileToRename->fileOp &= ~REUDIR_FILEOP_RENAME;
@@ -1397,12 +1464,10 @@ u32 readKeyRenderMenu( int fade )
 							foRenaming = 0;
 							char tmp[ 128 ];
 							sprintf( tmp, "%s%s", imageNameStr, imageNameExt );
-							if ( strcmp( (char*)pFileToRename->filename, tmp ) != 0 )
+							if ( strcmp( DIRENTRY_FILENAME( pFileToRename ), tmp ) != 0 )
 							{
-								strcpy( (char*)pFileToRename->rename, tmp );
-								//strcpy( (char*)pFileToRename->filename, (char*)pFileToRename->rename );
-								extern void makeFormattedName( REUDIRENTRY *d );
-								makeFormattedName( pFileToRename );
+								pFileToRename->rename = dirArenaAdd( tmp );
+								//pFileToRename->filename = pFileToRename->rename;
 								pFileToRename->fileOp |= REUDIR_FILEOP_RENAME;							
 //							debugg = 2;
 							} else
@@ -1431,6 +1496,21 @@ u32 readKeyRenderMenu( int fade )
 				goto test;
 			}
 
+			// while searching all keys go to the browser, only cursor up/down and DEL repeat
+			extern u32 browserSearchActive;
+			if ( browserSearchActive && !showHelp && !showTimings )
+			{
+				if ( k != lastKey || k == VK_UP || k == VK_DOWN || k == VK_DELETE )
+					handleKey( k );
+				if ( k != lastKey )
+				{
+					repKey = 0;
+					lastKey = k;
+				}
+				k = -1;
+				goto test;
+			}
+
 			if ( ( k == 'H' || showHelp ) && fadeToHelp == 0 )
 			{
 				if ( showHelp )
@@ -1512,6 +1592,7 @@ u32 readKeyRenderMenu( int fade )
 				radLoadGeoImage = false;
 				radLaunchVSF = false;
 				reu.isModified  = 0;
+				imageCacheDiscard();
 			} else
 
 			if ( k == 'T' ) 
@@ -1525,6 +1606,7 @@ u32 readKeyRenderMenu( int fade )
 				radLoadGeoImage = false;
 				radLaunchVSF = false;
 				reu.isModified  = 0;
+				imageCacheDiscard();
 			} else
 			if ( k == '+' || k == '-' ) 
 			{
@@ -1542,6 +1624,7 @@ u32 readKeyRenderMenu( int fade )
 				radLoadGeoImage = false;
 				radLaunchVSF = false;
 				reu.isModified = 0;
+				imageCacheDiscard();
 			} else
 			if ( !showIECDevice && ( k == 'I' || k == 'i' ) && IECDevicePresent )
 			{
@@ -1772,7 +1855,7 @@ test:
 		{
 			if ( foRenaming == 1 )
 			{
-				strncpy( imageNameStr, (const char*)pFileToRename->rename, 20 );
+				strncpy( imageNameStr, DIRENTRY_RENAME( pFileToRename ), 20 );
 
 				imageNameStrLength = min( 20, strlen( imageNameStr ) );
 
@@ -2285,12 +2368,12 @@ void prepareScreenAndSprites()
 	CACHE_PRELOAD_DATA_CACHE( &font_logo[ 0 ], 4096, CACHE_PRELOADL2KEEP )
 	FORCE_READ_LINEAR32a( &font_logo, 4096, 4096 * 8 );
 	BUS_RESYNC
-	SMEMCPY( CHARSET2, &font_logo[0], 0x1000*0+1600 );
+	POKE_MEMCPY( CHARSET2, 1600, &font_logo[0] );
 
 	CACHE_PRELOAD_DATA_CACHE( &font_bin[ 0 ], 4096, CACHE_PRELOADL2KEEP )
 	FORCE_READ_LINEAR32a( &font_bin, 4096, 4096 * 8 );
 	BUS_RESYNC
-	SMEMCPY( CHARSET, &font_bin[0], 0x1000 );
+	POKE_MEMCPY( CHARSET, 0x1000, &font_bin[0] );
 
 	const u8 vic[] = { 
 		0, 0, 0, 0, 0, 0, 0, 0, 
@@ -2336,9 +2419,7 @@ void prepareScreenAndSprites()
 		addr ++;
 	}
 
-	addr = 0x7800;
-	for ( int i = 0; i < 1024; i++ )
-		SPOKE( addr + i, 0 );
+	POKE_FILL( 0x7800, 1024, 0 );
 
 	// sprites
 	u32 o = 56+92;
@@ -2562,14 +2643,11 @@ restartHijacking:
 	SPOKE( 0xdd03, 0x06 );
 	SPOKE( 0xdd01, 0x06 );
 
-	for ( u32 i = 0; i < 1000; i++ )
-	{
-		SPOKE( 0xd800 + i, 0 );
-		SPOKE( SCREEN1 + i, 32 );
+	POKE_FILL( 0xd800, 1000, 0 );
+	POKE_FILL( SCREEN1, 1000, 32 );
 
-		// also clear original screen, not to be fooled by "READY." after reboot
-		SPOKE( 0x0400 + i, 32 );
-	}
+	// also clear original screen, not to be fooled by "READY." after reboot
+	POKE_FILL( 0x0400, 1000, 32 );
 
 
 
@@ -2682,6 +2760,7 @@ restartHijacking:
 
 	extern CLogger	*logger;
 	char imgFileName[ 512 ];
+	u32 saveCompressed;
 	u32 imgSize;
 
 	// init SID
@@ -2800,19 +2879,42 @@ restartHijacking:
 			for ( i = 4; i < 1024 * 6; i ++ )
 				handleOneRasterLine( i >> 2, 1 );
 
+			// compressed if the mounted image is, or if enabled in rad.cfg
+			saveCompressed = radImageCompression || lzIsCompressedImage( radImageSelectedFile );
+
 			if ( meType == 0 ) // REU
 			{
-				sprintf( imgFileName, "SD:REU/%s.reu", imageNameStr );
+				sprintf( imgFileName, saveCompressed ? "SD:REU/%s.reuz" : "SD:REU/%s.reu", imageNameStr );
 				extern u8 *mempoolPtr;
 				imgSize = ( 128 << meSize0 ) * 1024;
-				writeFile( logger, DRIVE, imgFileName, mempoolPtr, imgSize );
+				reuPagesFlush( mempoolPtr );
+
+				// compressed images are written completely, otherwise saving to the image the REU has
+				// been loaded from (or saved to) only rewrites modified pages
+				if ( saveCompressed )
+					writeFileLZ( logger, DRIVE, imgFileName, mempoolPtr, imgSize ); else
+				if ( imgSize != ( reuPages.nPages << REU_PAGE_SHIFT ) || !isSameFile( imgFileName, reuPages.image ) ||
+					 !writeFileBlocks( logger, DRIVE, imgFileName, mempoolPtr, imgSize, reuPages.state, REU_PAGE_DIRTY, REU_PAGE_SHIFT ) )
+					writeFile( logger, DRIVE, imgFileName, mempoolPtr, imgSize );
+				reuPagesSaved( imgFileName );
 			} else
 			if ( meType == 1 ) // GeoRAM
 			{
-				sprintf( imgFileName, "SD:GEORAM/%s.georam", imageNameStr );
+				sprintf( imgFileName, saveCompressed ? "SD:GEORAM/%s.georamz" : "SD:GEORAM/%s.georam", imageNameStr );
 				extern u8 *mempoolPtr;
+				extern u32 geoSizeKB;
+				extern u8 geoDirty[];
+				extern char geoImage[];
 				imgSize = ( 512 << meSize1 ) * 1024;
-				writeFile( logger, DRIVE, imgFileName, mempoolPtr, imgSize );
+
+				// same for GeoRAM with 16 KB blocks
+				if ( saveCompressed )
+					writeFileLZ( logger, DRIVE, imgFileName, mempoolPtr, imgSize ); else
+				if ( imgSize != geoSizeKB * 1024 || !isSameFile( imgFileName, geoImage ) ||
+					 !writeFileBlocks( logger, DRIVE, imgFileName, mempoolPtr, imgSize, geoDirty, 1, 14 ) )
+					writeFile( logger, DRIVE, imgFileName, mempoolPtr, imgSize );
+				memset( geoDirty, 0, imgSize >> 14 );
+				strncpy( geoImage, imgFileName, 1023 );
 			} 
 				
 			reu.isModified = false;
@@ -3034,39 +3136,15 @@ static void convertWAV2RAW_inplace( u8 *_data )
 //
 //
 
-int substr( char *str, char *strsearch )
-{
-    char *t = strstr( str, strsearch );
-    return (u64)t - (u64)str;
-}
-
-bool substr( char *str, int ofs, char *strsearch )
-{
-    char *t = strstr( str + ofs, strsearch );
-    if ( t != NULL ) return true;
-    return false;
-}
+#include "vsf_file.h"
 
+// modules are looked up in the directory built by vsfRead() (see vsf_file.h)
 u8 *getVSFModule( u8 *vsf, int vsfSize, char *modulename )
 {
-    int i = 0x3a, modLen;
-    bool found = false;
-    u8 *p = NULL;
-    do {
-        modLen = (int)vsf[ i + 0x12 ] + ( (int)vsf[ i + 0x13 ] << 8 ) +
-                 ( (int)vsf[ i + 0x14 ] << 16 ) + ( (int)vsf[ i + 0x15 ] << 24 );
-        
-        if ( substr( (char*)vsf, i, modulename ) )
-        {
-            found = true;
-            p = &vsf[ i ];
-        } else
-        {
-            i += modLen;
-        }
-    } while ( !found && ( i < vsfSize ) );
-    
-    return p;
+	VSFMODULE *m = vsfFindModule( modulename );
+	if ( m == NULL || (int)m->bufOfs >= vsfSize )
+		return NULL;
+	return &vsf[ m->bufOfs ];
 }
 
 #include "C64Side/ultimax_vsf.h"
@@ -3078,6 +3156,33 @@ static u8 code[ 256 ];
 static int vsfRasterLine, vsfRasterCycle;
 static u8 *vsfREU = NULL;
 
+// writes $0002-$ffff, the verified restore reads every page back and rewrites the ones which differ (see vsf_file.h)
+static void restoreRAMVSF( u8 *mem )
+{
+	if ( !radVSFVerify )
+	{
+		POKE_BURST_NG( 2, 65534, &mem[ 2 ], 0 );
+		return;
+	}
+
+	VSFRESTORESTATS *s = &vsfRestoreStats;
+	u8 page[ 256 ];
+
+	for ( u32 a = 2; a < 65536; )
+	{
+		u32 n = 256 - ( a & 255 );
+
+		PEEK_BURST_NG( a, n, page );
+		if ( memcmp( page, &mem[ a ], n ) )
+		{
+			s->bytesFailed += POKE_BURST_NG( a, n, &mem[ a ], POKE_BURST_VERIFY_ALL );
+			s->pagesWritten ++;
+		} else
+			s->pagesMatching ++;
+		a += n;
+	}
+}
+
 void __attribute__ ((noinline)) doInjectionVSF( u8 *vsf, u32 vsfSize )
 {
 	u8 *cpu, *mem, *cia1, *cia2, *sid, *vic;
@@ -3110,8 +3215,7 @@ void __attribute__ ((noinline)) doInjectionVSF( u8 *vsf, u32 vsfSize )
 	if ( isC128Snapshot )
 	{
 		//mem = getVSFModule( vsf, vsfSize, (char *)"C128MEM" ) + VSF_SIZE_MODULE_HEADER + 11;
-		for ( int i = 2; i < 65536; i++ )
-			SPOKE_NG( i, mem[ i ] );
+		restoreRAMVSF( mem );
 	} else
 	{
 		// offset memory dump = 26 = VSF_SIZE_MODULE_HEADER + 4
@@ -3119,8 +3223,7 @@ void __attribute__ ((noinline)) doInjectionVSF( u8 *vsf, u32 vsfSize )
 		// EXROM / GAME = 24 and 25 = VSF_SIZE_MODULE_HEADER + 2
 		//	mem = getVSFModule( vsf, vsfSize, (char *)"C64MEM" ) + VSF_SIZE_MODULE_HEADER;
 		u8 *ppp = mem + 4;
-		for ( int i = 2; i < 65536; i++ )
-			SPOKE_NG( i, ppp[ i ] );
+		restoreRAMVSF( ppp );
 
 	}
 
@@ -3167,15 +3270,13 @@ void __attribute__ ((noinline)) doInjectionVSF( u8 *vsf, u32 vsfSize )
 		for ( int i = 0; i < 0x2f; i++ )
 			SPOKE_NG( 0xd000 + i, vic[ i + 1119 ] );
 
-		for ( int i = 0; i < 0x400; i++ )
-			SPOKE_NG( 0xd800 + i, vic[ i + 43 ] );
+		POKE_BURST_NG( 0xd800, 0x400, &vic[ 43 ], 0 );
 	} else
 	{
 		for ( int i = 0; i < 0x2f; i++ )
 			SPOKE_NG( 0xd000 + i, vic[ i + 1 ] );
 
-		for ( int i = 0; i < 0x400; i++ )
-			SPOKE_NG( 0xd800 + i, vic[ i + 761 ] );
+		POKE_BURST_NG( 0xd800, 0x400, &vic[ 761 ], 0 );
 	}
 
 	// 
@@ -3285,8 +3386,8 @@ void __attribute__ ((noinline)) doInjectionVSF( u8 *vsf, u32 vsfSize )
 		extern void warmCache();
 		warmCache();
 
-		CACHE_PRELOAD_INSTRUCTION_CACHE( (void*)reuUsingPolling, 1024 * 7 );
-		FORCE_READ_LINEARa( (void*)reuUsingPolling, 1024 * 7, 65536 );
+		CACHE_PRELOAD_INSTRUCTION_CACHE( __start_section_polling, REU_POLLING_CODE_SIZE );
+		FORCE_READ_LINEARa( __start_section_polling, REU_POLLING_CODE_SIZE, 65536 );
 
 		reuUsingPolling( 1 );
 	}
@@ -3404,3 +3505,199 @@ vsfCRTCFG:
 			goto restartInjection;
 	}
 }
+
+
+#include "C64Side/ultimax_freeze.h"
+#include "freeze.h"
+
+// samples a running CIA timer (Ultimax mode), the largest value seen approximates the write-only latch:
+// the counter only increases when it is reloaded, after that (or one full period) we are done
+static u16 freezeTimerLatch( u16 reg )
+{
+	u32 g2;
+	u8 lo, hi;
+	u16 v, prev = 0xffff, latch = 0;
+
+	BUS_RESYNC
+	for ( u32 i = 0; i < 65536 / 2; i++ )
+	{
+		PEEK_NG( reg, lo );
+		PEEK_NG( reg + 1, hi );
+		v = (u16)lo | ( (u16)hi << 8 );
+		if ( v > latch ) latch = v;
+		if ( v > prev && v - prev > 512 ) break;
+		prev = v;
+	}
+	return latch;
+}
+
+// reads the registers of a CIA without side effects (Ultimax mode): the interrupt control register is skipped,
+// the TOD hours are read first and the tenths last such that the TOD output latch is released again
+static void freezeCIA( u16 base, u8 *cia, u8 ier )
+{
+	u32 g2;
+
+	memset( cia, 0, 20 );
+	PEEK_BURST_NG( base, 8, cia );
+
+	BUS_RESYNC
+	for ( int i = 11; i >= 8; i-- )
+		PEEK_NG( base + i, cia[ i ] );
+	PEEK_NG( base + 0x0c, cia[ 12 ] );
+	PEEK_NG( base + 0x0e, cia[ 14 ] );
+	PEEK_NG( base + 0x0f, cia[ 15 ] );
+
+	u16 latchA = cia[ 4 ] | ( cia[ 5 ] << 8 );
+	u16 latchB = cia[ 6 ] | ( cia[ 7 ] << 8 );
+
+	if ( cia[ 14 ] & 1 ) latchA = freezeTimerLatch( base + 4 );
+	if ( cia[ 15 ] & 1 ) latchB = freezeTimerLatch( base + 6 );
+
+	cia[ 16 ] = latchA & 255; cia[ 17 ] = latchA >> 8;
+	cia[ 18 ] = latchB & 255; cia[ 19 ] = latchB >> 8;
+
+	// the interrupt mask cannot be read: assume timer A interrupts if it runs continuously (as set up by the kernal)
+	if ( ( cia[ 14 ] & 0x09 ) == 0x01 )
+		cia[ 13 ] = ier;
+}
+
+int freezeC64( FREEZESTATE *f )
+{
+	register u32 g2, g3;
+	u8  regs[ 8 ] = { 0 };
+	u32 nWrites = 0, frozen = 0, cycles = 0;
+
+	CACHE_PRELOAD_DATA_CACHE( &ultimax_freeze[ 0 ], 256, CACHE_PRELOADL2KEEP )
+	FORCE_READ_LINEAR32a( &ultimax_freeze, 256, 256 * 32 );
+	CACHE_PRELOAD_INSTRUCTION_CACHE( &&freezeIRQ, 4096 );
+
+	OUT_GPIO( GAME_OUT );
+	SET_GPIO( bGAME_OUT | bDMA_OUT );
+	CLR_GPIO( bMPLEX_SEL );
+
+freezeIRQ:
+	WAIT_FOR_CPU_HALFCYCLE
+	BEGIN_CYCLE_COUNTER
+	WAIT_FOR_VIC_HALFCYCLE
+	write32( ARM_GPIO_GPCLR0, bIRQ_OUT );
+	OUT_GPIO_IRQ();
+
+	while ( !frozen )
+	{
+		WAIT_FOR_CPU_HALFCYCLE
+		RESTART_CYCLE_COUNTER						
+		WAIT_UP_TO_CYCLE( WAIT_FOR_SIGNALS + TIMING_OFFSET_CBTD );
+		g2 = read32( ARM_GPIO_GPLEV0 );
+
+		SET_GPIO( bMPLEX_SEL );
+		WAIT_UP_TO_CYCLE( WAIT_CYCLE_MULTIPLEXER );
+		
+		g3 = read32( ARM_GPIO_GPLEV0 );
+		CLR_GPIO( bMPLEX_SEL );
+
+		if ( nWrites < 3 )
+		{
+			// taking the interrupt, the CPU pushes PCH, PCL and P in 3 consecutive write cycles
+			if ( CPU_WRITES_TO_BUS ) nWrites ++; else nWrites = 0;
+		} else
+		if ( ADDRESS_FFxx && CPU_READS_FROM_BUS )
+		{
+			u8 D = ultimax_freeze[ ADDRESS0to7 ];
+
+			register u32 DD = ( ( D ) & 255 ) << D0;
+			write32( ARM_GPIO_GPCLR0, ( D_FLAG & ( ~DD ) ) | bOE_Dx | bDIR_Dx );
+			write32( ARM_GPIO_GPSET0, DD );
+			SET_BANK2_OUTPUT
+			WAIT_UP_TO_CYCLE( WAIT_CYCLE_READ );
+			SET_GPIO( bOE_Dx | bDIR_Dx );
+		} else
+		if ( IO1_ACCESS && CPU_WRITES_TO_BUS )
+		{
+			SET_BANK2_INPUT
+			CLR_GPIO( bOE_Dx );
+			WAIT_UP_TO_CYCLE( WAIT_CYCLE_WRITEDATA );
+			u8 D = ( read32( ARM_GPIO_GPLEV0 ) >> D0 ) & 255;
+			SET_GPIO( bOE_Dx );
+			SET_BANK2_OUTPUT
+
+			regs[ IO_ADDRESS & 7 ] = D;
+			if ( ( IO_ADDRESS & 7 ) == 6 )
+				frozen = 1;
+		}
+
+		WAIT_FOR_VIC_HALFCYCLE
+
+		// ... and the vectors are read from the Ultimax "ROM"
+		if ( nWrites == 3 )
+		{
+			CLR_GPIO( bGAME_OUT );
+			SET_GPIO( bIRQ_OUT );
+			INP_GPIO_IRQ();
+			nWrites ++;
+		}
+
+		if ( ++ cycles > FREEZE_IRQ_TIMEOUT && !frozen )
+		{
+			SET_GPIO( bIRQ_OUT | bGAME_OUT );
+			INP_GPIO_IRQ();
+			return 0;
+		}
+	}
+
+	// the CPU is in its endless loop now, no write cycles follow
+	RESTART_CYCLE_COUNTER
+	WAIT_UP_TO_CYCLE( TIMING_TRIGGER_DMA );
+	CLR_GPIO( bDMA_OUT );
+	WAIT_FOR_CPU_HALFCYCLE
+	WAIT_FOR_VIC_HALFCYCLE
+	WAIT_FOR_CPU_HALFCYCLE
+	WAIT_FOR_VIC_HALFCYCLE
+	WAIT_FOR_CPU_HALFCYCLE
+	WAIT_FOR_VIC_HALFCYCLE
+
+	f->a = regs[ 0 ];
+	f->x = regs[ 1 ];
+	f->y = regs[ 2 ];
+	f->sp = regs[ 3 ] + 3;
+	f->port0 = regs[ 4 ];
+	f->port1 = regs[ 5 ];
+
+	// I/O in Ultimax mode: raster position first (the cycle is estimated from the time until the next line starts)
+	u8 d011, d012, v;
+	u32 cyclesPerLine = 63 + isNTSC, n = 0;
+	BUS_RESYNC
+	PEEK_NG( 0xd012, d012 );
+	PEEK_NG( 0xd011, d011 );
+	do {
+		PEEK_NG( 0xd012, v );
+	} while ( v == d012 && ++ n < cyclesPerLine );
+
+	f->rasterLine = d012 | ( ( d011 & 0x80 ) << 1 );
+	f->rasterCycle = cyclesPerLine - n;
+
+	PEEK_BURST_NG( 0xd000, 0x2f, f->vic );
+	PEEK_BURST_NG( 0xd800, 1024, f->colorRAM );
+	for ( u32 i = 0; i < 1024; i++ )
+		f->colorRAM[ i ] &= 15;
+
+	freezeCIA( 0xdc00, f->cia1, 0x01 );
+	freezeCIA( 0xdd00, f->cia2, 0x00 );
+
+	// only the last 4 SID registers can be read
+	memset( f->sid, 0, 0x20 );
+	PEEK_BURST_NG( 0xd419, 4, &f->sid[ 0x19 ] );
+
+	// $01 = $30: RAM everywhere
+	INP_GPIO( GAME_OUT );
+	SET_GPIO( bGAME_OUT );
+
+	f->ram[ 0 ] = f->port0;
+	f->ram[ 1 ] = f->port1;
+	PEEK_BURST( 2, 65534, &f->ram[ 2 ] );
+
+	// P, PCL and PCH as pushed by the interrupt
+	f->p  = f->ram[ 0x100 + (u8)( regs[ 3 ] + 1 ) ];
+	f->pc = f->ram[ 0x100 + (u8)( regs[ 3 ] + 2 ) ] | ( f->ram[ 0x100 + (u8)( regs[ 3 ] + 3 ) ] << 8 );
+
+	return 1;
+}
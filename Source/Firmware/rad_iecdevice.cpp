@@ -1399,9 +1399,9 @@ s32 addSyncFile( REUDIRENTRY *f )
 
 	if ( i >= MAX_SYNC_FILES ) return -1;
 
-	memcpy( syncFile[ i ].path, f->path, 1024 );
-	memcpy( syncFile[ i ].filename, f->filename, 256 );
-	memcpy( syncFile[ i ].name, f->name, 256 );
+	dirEntryPath( f, (char *)syncFile[ i ].path );
+	strncpy( (char *)syncFile[ i ].filename, DIRENTRY_FILENAME( f ), 255 );
+	makeFormattedName( f, (char *)syncFile[ i ].name );
 	syncFile[ i ].size = f->size;
 	syncFile[ i ].flags = IECSYNC_NOT_SYNCED;
 
@@ -1426,7 +1426,10 @@ s32 indexOfSyncFile( const char *path, const char *filename, u32 size )
 
 s32 removeSyncFile( REUDIRENTRY *f )
 {
-	s32 idx = indexOfSyncFile( (const char *)f->path, (const char *)f->filename, f->size );
+	char path[ 1024 ], filename[ 256 ];
+	dirEntryPath( f, path );
+	strncpy( filename, DIRENTRY_FILENAME( f ), 255 );
+	s32 idx = indexOfSyncFile( path, filename, f->size );
 
 	if ( idx < 0 ) return -1;
 
@@ -1474,14 +1477,14 @@ void markSyncFilesRAD()
 		{
 			f->f &= ~REUDIR_MARKSYNC;
 
-			int idx = indexOfSyncFile_FileNameSize( syncFileOnDevice, nSyncFileOnDevice, (char *)f->filename, f->size );
+			int idx = indexOfSyncFile_FileNameSize( syncFileOnDevice, nSyncFileOnDevice, (char *)DIRENTRY_FILENAME( f ), f->size );
 
 			if ( idx == -1 )
-				idx = indexOfSyncFile_FileNameSize( syncFileChanges, nSyncFileChanges, (char *)f->filename, f->size );
+				idx = indexOfSyncFile_FileNameSize( syncFileChanges, nSyncFileChanges, (char *)DIRENTRY_FILENAME( f ), f->size );
 
 			if ( idx != -1 )
 			{
-				int idx_rm = indexOfSyncFile_FileNameSize( syncRemoveFiles, nRemoveFiles, (char *)f->filename, f->size );
+				int idx_rm = indexOfSyncFile_FileNameSize( syncRemoveFiles, nRemoveFiles, (char *)DIRENTRY_FILENAME( f ), f->size );
 				if ( idx_rm == -1 )
 					f->f |= REUDIR_MARKSYNC;
 			}
@@ -0,0 +1,86 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - job queues for the service cores
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <circle/sysconfig.h>
+#include "rad_jobs.h"
+
+JOBRING jobRing[ JOB_CORES ] AAA;
+
+int jobPost( u32 core, JOBFUNC func, void *param )
+{
+	JOBRING *r = &jobRing[ core ];
+	u32 head = r->head;
+
+	if ( head - r->tail >= JOB_RING_SIZE )
+		return 0;
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	r->job[ head & ( JOB_RING_SIZE - 1 ) ].func = func;
+	r->job[ head & ( JOB_RING_SIZE - 1 ) ].param = param;
+
+	// the job has to be visible before the new head
+	MEMORY_BARRIER
+	r->head = head + 1;
+	SIGNAL_EVENT
+#else
+	func( param );
+#endif
+
+	return 1;
+}
+
+void jobWait( u32 core )
+{
+	while ( !jobIdle( core ) )
+		WAIT_FOR_EVENT
+
+	// results of the jobs are visible after this
+	MEMORY_BARRIER
+}
+
+void jobWorker( u32 core )
+{
+	JOBRING *r = &jobRing[ core ];
+
+	while ( 1 )
+	{
+		u32 tail = r->tail;
+
+		while ( r->head == tail )
+			WAIT_FOR_EVENT
+
+		MEMORY_BARRIER
+		RADJOB *j = &r->job[ tail & ( JOB_RING_SIZE - 1 ) ];
+		j->func( j->param );
+
+		// results of the job have to be visible before the slot is released
+		MEMORY_BARRIER
+		r->tail = tail + 1;
+		SIGNAL_EVENT
+	}
+}
@@ -0,0 +1,81 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - job queues for the service cores
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _rad_jobs_h
+#define _rad_jobs_h
+
+#include <circle/types.h>
+#include "lowlevel_arm64.h"
+
+// core 0 owns the GPIOs and runs the bus emulation (and the menu), it never waits for another core while the
+// C64 is running; file I/O during the emulation (streaming and autosaving images) is posted to JOB_CORE_IO instead.
+// FatFs is not reentrant: core 0 calls readFile/writeFile etc. itself only when no job is pending, i.e. after
+// jobWait( JOB_CORE_IO ) (see rad_main.cpp and reuLoaderStart)
+// the service core has a single-producer/single-consumer ring (producer: core 0, consumer: the service core);
+// the cores share coherent caches, head and tail are written by one side only and live in separate cache lines
+#define JOB_CORE_IO			1
+#define JOB_CORES			4
+
+#define JOB_RING_SIZE		16		// power of 2
+
+typedef void ( *JOBFUNC )( void *param );
+
+typedef struct
+{
+	JOBFUNC func;
+	void *param;
+} RADJOB;
+
+typedef struct
+{
+	volatile u32 head;				// next free slot, written by core 0
+	u32 pad0[ 15 ];
+	volatile u32 tail;				// next job to run, advanced by the service core after the job has finished
+	u32 pad1[ 15 ];
+	RADJOB job[ JOB_RING_SIZE ];
+} JOBRING;
+
+extern JOBRING jobRing[ JOB_CORES ] AAA;
+
+// queues a job, returns 0 if the ring is full (never blocks)
+// (without ARM_ALLOW_MULTI_CORE the job is executed right away)
+extern int jobPost( u32 core, JOBFUNC func, void *param );
+
+// all posted jobs of a core have finished
+__attribute__( ( always_inline ) ) inline u32 jobIdle( u32 core )
+{
+	return jobRing[ core ].tail == jobRing[ core ].head;
+}
+
+// blocks until all posted jobs of a core have finished (not to be used while the C64 is running)
+extern void jobWait( u32 core );
+
+// main loop of a service core, never returns
+extern void jobWorker( u32 core );
+
+#endif
@@ -41,6 +41,17 @@ static const char FILENAME_CONFIG[] = "SD:RAD/rad.cfg";
 
 // REU
 #include "rad_reu.h"
+#include "reu_trace.h"
+#include "reu_prefetch.h"
+#include "reu_pages.h"
+#include "reu_loader.h"
+#include "autosave.h"
+#include "image_cache.h"
+#include "fingerprint.h"
+#include "reu_profile.h"
+#include "freeze.h"
+#include "vsf_file.h"
+#include "lz_image.h"
 #define REU_MAX_SIZE_KB	(16384)
 u8 mempool[ REU_MAX_SIZE_KB * 1024 + 8192 ] AAA = {0};
 u8 *mempoolPtr = &mempool[ 0 ];
@@ -54,26 +65,26 @@ u64 armCycleCounter;
 #include "rad_georam.h"
 
 // VSF
-u8 vsf[ 17 * 1024 * 1024 ] = {0};
+u8 vsf[ VSF_BUFFER_SIZE ] = {0};
 
 void warmCache()
 {
 	for ( int i = min( REU_SIZE_KB, 256 ) * 1024 - 64; i >= 0; i -= 64 )
-		CACHE_PRELOADL2KEEP( &mempool[ i ] );
+		CACHE_PRELOADL2KEEP( &mempoolPtr[ i ] );
 
 	CACHE_PRELOAD_DATA_CACHE( &reu, sizeof( REUSTATE ), CACHE_PRELOADL1KEEP )
 	FORCE_READ_LINEAR32a( &reu, sizeof( REUSTATE ), sizeof( REUSTATE ) * 8 );
 
-	CACHE_PRELOAD_INSTRUCTION_CACHE( (void*)reuUsingPolling, 1024 * 7 );
-	FORCE_READ_LINEARa( (void*)reuUsingPolling, 1024 * 7, 65536 );
+	CACHE_PRELOAD_INSTRUCTION_CACHE( __start_section_polling, REU_POLLING_CODE_SIZE );
+	FORCE_READ_LINEARa( __start_section_polling, REU_POLLING_CODE_SIZE, 65536 );
 }
 
 void warmCacheGeoRAM()
 {
 	for ( int k = 0; k < 1024; k += 64 )
-		CACHE_PRELOADL2STRM( &mempool[ k ] );
+		CACHE_PRELOADL2STRM( &mempoolPtr[ k ] );
 
-	FORCE_READ_LINEARa( &mempool[ 0 ], 1024, 1024 * 64 );
+	FORCE_READ_LINEARa( &mempoolPtr[ 0 ], 1024, 1024 * 64 );
 
 	CACHE_PRELOAD_INSTRUCTION_CACHE( (void*)geoRAMUsingPolling, 1024 * 2 );
 	FORCE_READ_LINEARa( (void*)geoRAMUsingPolling, 1024 * 2, 65536 );
@@ -167,39 +178,10 @@ void startForcedResetVectors()
 }
 
 
-//#define REU_PROTOCOL
-#ifdef REU_PROTOCOL
-REUPROT reuProtocol[ 65536 ];
-u32 nReuProtocol = 0;
-#endif
-
 #include "rad_hijack.h"
 
 volatile u8 bla = 0;
 
-u8 reuImageIsNuvie( u8 *m )
-{
-	u8 pat1[ 16 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };	// 0x8f00f0
-	u8 pat2[ 7 ] = { 0x30, 0x30, 0x31, 0x16, 0x31, 0x2e, 0x30 }; // 0x0000f5
-	if ( memcmp( pat1, &m[ 0x8f00f0 ], 16 ) == 0 || memcmp( pat2, &m[ 0x0000f5 ], 7 ) == 0 )
-		return SPECIAL_NUVIE;
-	return 0;
-}
-
-bool reuImageIsBlureu( u8 *m, u32 size )
-{
-   	u32 crc = 0xffffffff;
-	for ( u32 i = 0; i < size; i++ )
-	{
-      	crc ^= *(m++);
-      	for ( u8 j = 0; j < 8; j++ ) 
-        	crc = (crc >> 1) ^ (0xEDB88320 & (-(crc & 1)));
-	}
-	if ( crc == 0xd569cb25 )
-		return SPECIAL_BLUREU;
-	return 0;
-}
-
 u32 temperature;
 
 #define WAIT_FOR_READY_PROMPT \
@@ -222,6 +204,7 @@ void CRAD::Run( void )
 
 	setDefaultTimings( AUTO_TIMING_RPI3PLUS_C64C128 );
 	readConfig( logger, DRIVE, FILENAME_CONFIG );
+	readProfiles( logger, DRIVE, FILENAME_PROFILES );
 
 	OUT_GPIO( RESET_OUT );
 	CLR_GPIO( bRESET_OUT );
@@ -237,13 +220,10 @@ void CRAD::Run( void )
 	// this also initializes timing values
 	REU_SIZE_KB = 128;
 	initREU( mempool );
+	imageCacheInit( logger, mempool, m_Memory.GetHeapFreeSpace( HEAP_ANY ) );
 
 	initHijack();
 
-#ifdef REU_PROTOCOL
-	nReuProtocol = 0;
-#endif
-
 	#ifdef FORCE_RESET_VECTORS
 	resetVector = 0xfce2;
 	#endif
@@ -252,6 +232,7 @@ void CRAD::Run( void )
 	u8 isC128PRG = 0;
 	u8 go64mode = 0;
 	int res = 0;
+	int frozen = 0;
 
 	DisableIRQs();
 
@@ -307,8 +288,41 @@ void CRAD::Run( void )
 
 
 	hijacking:
+		// with "FREEZE ON" the program is captured right away, but only saved if the button is held (see freeze.h)
+		frozen = 0;
+		if ( radFreeze && !isC128 && freezeC64( &freezeState ) )
+		{
+			for ( u32 t = 0; t < FREEZE_HOLD_MS / 10; t++ )
+			{
+				g2 = read32( ARM_GPIO_GPLEV0 );
+				if ( !BUTTON_PRESSED ) break;
+				CTimer::SimpleMsDelay( 10 );
+			}
+			frozen = BUTTON_PRESSED;
+		}
+
+		// in persistent mode the image file is up to date already
+		if ( autosaveStop() )
+			reu.isModified = 0;
+
+		// streamed images are complete and all file I/O of the service core has finished before the menu uses the SD card
+		jobWait( JOB_CORE_IO );
+
+		if ( frozen )
+		{
+			if ( reuRunning )
+				reuPagesFlush( mempoolPtr );
+			freezeWriteVSF( logger, DRIVE, FILENAME_FREEZE, &freezeState, reuRunning ? mempoolPtr : NULL, reu.reuSize / 1024 );
+		}
 		temperature = m_CPUThrottle.GetTemperature();
 
+	#ifdef PERF_HEADROOM
+		perfHeadroomDump( logger, DRIVE, m_CPUThrottle.GetClockRate() / 1000000 );
+	#endif
+		reuTraceFlush( logger, DRIVE, m_CPUThrottle.GetClockRate() / 1000000 );
+		reuPrefetchReport( logger );
+		vsfRestoreReport( logger );
+
 		SyncDataAndInstructionCache();
 		CACHE_PRELOAD_INSTRUCTION_CACHE( (void*)hijackC64, 1024 * 10 );
 		FORCE_READ_LINEARa( (void*)hijackC64, 1024 * 10, 65536 );
@@ -323,6 +337,7 @@ void CRAD::Run( void )
 		///////////////////////////////////////////////////////////////////////
 
 		res = hijackC64( false );			// after hijackC64 the CPU is still halted by DMA
+		reuRunning = false;
 
 		WAIT_FOR_CPU_HALFCYCLE
 		WAIT_FOR_VIC_HALFCYCLE
@@ -386,6 +401,7 @@ void CRAD::Run( void )
 
 		if ( res == RUN_REBOOT )
 		{
+			fsFlush();
 			reboot(); 
 		} else
 		///////////////////////////////////////////////////////////////////////
@@ -397,29 +413,36 @@ void CRAD::Run( void )
 		{
 		startREUEmulation:
 			REU_SIZE_KB = 128 << meSize0;
-			initREU(mempool);
+
+			// an image which is still resident does not need to be loaded again (see image_cache.h)
+			u32 cached, size;
+			imageCacheSelect( logger, DRIVE, radLoadREUImage ? radImageSelectedFile : NULL, IMAGECACHE_REU, &cached );
+			initREU( mempoolPtr );
 			resetREU();
 
+			if ( cached )
+			{
+				reu.isModified = imageCacheRestore( &size );
+				autosaveStart( logger, DRIVE, radImageSelectedFile, mempoolPtr, size, reuPages.state, REU_PAGE_DIRTY, REU_PAGE_SHIFT );
+			} else
 			if ( radLoadREUImage )
 			{
-				u32 size;
-				readFile( logger, (char*)DRIVE, (char*)radImageSelectedFile, mempool, &size );
-
-				reu.isSpecial = reuImageIsNuvie( mempool );
-				if ( !reu.isSpecial )
-					reu.isSpecial = reuImageIsBlureu( mempool, size );
-		} else
+				// the emulation starts right away, the image is read by the I/O core (see reu_loader.h)
+				reuLoaderStart( logger, DRIVE, radImageSelectedFile, mempoolPtr, &size );
+				autosaveStart( logger, DRIVE, radImageSelectedFile, mempoolPtr, size, reuPages.state, REU_PAGE_DIRTY, REU_PAGE_SHIFT );
+				reu.isModified = 0;
+			} else
 			{
-				memset( mempool, 0, reu.reuSize );
+				// no memset: the pages are zero-filled while the REU emulation is running (see reu_pages.h)
 				#ifdef STATUS_MESSAGES
 				char tmp[ 40 ];
 				sprintf( tmp, "%dK REU", reu.reuSize / 1024 );
 				setStatusMessage( &statusMsg[ 0 ], tmp );
 				#endif
+				reu.isModified = 0;
+				reuImageFingerprint = reuImageSpecial = 0;
 			}
 
-			reu.isModified = 0;
-
 			if ( radLaunchPRG )
 			{
 				// wait for "READY." to appear on screen
@@ -439,10 +462,14 @@ void CRAD::Run( void )
 			for ( u32 i = 0; i < 1000; i++ )
 				emuWAIT_FOR_VIC_HALFCYCLE
 
-			CACHE_PRELOAD_INSTRUCTION_CACHE( (void*)reuUsingPolling, 1024 * 7 );
-			FORCE_READ_LINEARa( (void*)reuUsingPolling, 1024 * 7, 65536 );
+			CACHE_PRELOAD_INSTRUCTION_CACHE( __start_section_polling, REU_POLLING_CODE_SIZE );
+			FORCE_READ_LINEARa( __start_section_polling, REU_POLLING_CODE_SIZE, 65536 );
 
 			resetREU();
+			reuTraceReset( radLoadREUImage ? radImageSelectedFile : NULL );
+			reuPrefetchReset( radLoadREUImage ? radImageSelectedFile : NULL );
+			reuProfileApply( reuImageFingerprint );
+			reuRunning = true;
 			reuUsingPolling();
 		} else
 		///////////////////////////////////////////////////////////////////////
@@ -456,13 +483,22 @@ void CRAD::Run( void )
 			// GeoRAM
 			geoSizeKB = 512 << meSize1;
 
-			geoRAM_Init();
+			u32 cached, size, modified = 0;
+			imageCacheSelect( logger, DRIVE, radLoadGeoImage ? radImageSelectedFile : NULL, IMAGECACHE_GEORAM, &cached );
+			geoRAM_Init( cached );
 
+			if ( cached )
+			{
+				modified = imageCacheRestore( &size );
+				autosaveStart( logger, DRIVE, radImageSelectedFile, geo.RAM, size, geoDirty, 1, 14 );		// 16 KB blocks
+			} else
 			if ( radLoadGeoImage )
 			{
-				u32 size;
-				static const char DRIVE[] = "SD:";
-				readFile( logger, (char*)DRIVE, (char*)radImageSelectedFile, geo.RAM, &size );
+				if ( lzIsCompressedImage( radImageSelectedFile ) )
+					readFileLZ( logger, (char*)DRIVE, (char*)radImageSelectedFile, geo.RAM, &size, NULL ); else
+					readFile( logger, (char*)DRIVE, (char*)radImageSelectedFile, geo.RAM, &size );
+				strncpy( geoImage, radImageSelectedFile, 1023 );
+				autosaveStart( logger, DRIVE, radImageSelectedFile, geo.RAM, size, geoDirty, 1, 14 );		// 16 KB blocks
 			} else
 			{
 				#ifdef STATUS_MESSAGES
@@ -493,7 +529,7 @@ void CRAD::Run( void )
 				}
 			}
 
-			geo.isModified = 0;
+			geo.isModified = modified;
 
 			SyncDataAndInstructionCache();
 			warmCacheGeoRAM();
@@ -556,10 +592,12 @@ void CRAD::Run( void )
 		///////////////////////////////////////////////////////////////////////
 		if ( res == RUN_MEMEXP + 4 ) 
 		{
-			// load VSF
+			// load VSF, only the modules needed (see vsf_file.h)
 			u32 vsfSize;
-			readFile( logger, (char*)DRIVE, (char*)radImageSelectedFile, vsf, &vsfSize );
+			if ( !vsfRead( logger, DRIVE, radImageSelectedFile, vsf, VSF_BUFFER_SIZE, &vsfSize ) )
+				goto radIsWaiting;
 			reu.isSpecial = false;
+			reuImageFingerprint = reuImageSpecial = 0;
 
 			u8 *vsfREU = getVSFModule( vsf, vsfSize, (char *)"REU1764" );
 			
@@ -567,7 +605,9 @@ void CRAD::Run( void )
 			if ( vsfREU )
 			{
 				REU_SIZE_KB = (int)vsfREU[ VSF_SIZE_MODULE_HEADER + 0 ] + ( (int)vsfREU[ VSF_SIZE_MODULE_HEADER + 1 ] << 8 ) + ( (int)vsfREU[ VSF_SIZE_MODULE_HEADER + 2 ] << 16 ) + ( (int)vsfREU[ VSF_SIZE_MODULE_HEADER + 3 ] << 24 );
-				initREU(mempool);
+				u32 cached;
+				imageCacheSelect( logger, DRIVE, NULL, IMAGECACHE_REU, &cached );
+				initREU( mempoolPtr );
 
 				// transfer register content
 		        u8 *reuRegisterData = &vsfREU[ VSF_SIZE_MODULE_HEADER + 4 ];
@@ -580,12 +620,16 @@ void CRAD::Run( void )
 				reu.IRQmask = reuRegisterData[ 9 ];
 				reu.addrREUCtrl = reuRegisterData[ 10 ];
 
-				// copy REU data
-		        u8 *reuMem = &vsfREU[ VSF_SIZE_MODULE_HEADER + 20 ];
-				memcpy( mempool, reuMem, REU_SIZE_KB * 1024 );
+				// REU data is read from the file directly
+				vsfReadREU( logger, DRIVE, mempoolPtr, REU_SIZE_KB * 1024 );
+				reuPagesLoaded( mempoolPtr, REU_SIZE_KB * 1024, NULL );
 			}
 			reu.isModified = 0;
 
+			reuTraceReset( radImageSelectedFile );
+			reuPrefetchReset( radImageSelectedFile );
+			reuProfileApply( reuImageFingerprint );
+			reuRunning = vsfREU != NULL;
 			resetAndInjectVSF( vsf, vsfSize );
 
 			goto radIsWaiting;
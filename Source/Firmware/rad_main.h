@@ -45,13 +45,33 @@
 #include <circle/gpiopinfiq.h>
 #include <circle/gpiomanager.h>
 #include <circle/util.h>
+#include <circle/sysconfig.h>
+#ifdef ARM_ALLOW_MULTI_CORE
+#include <circle/multicore.h>
+#endif
 
 #include "lowlevel_arm64.h"
 #include "gpio_defs.h"
 #include "helpers.h"
+#include "rad_jobs.h"
 
 CLogger	*logger;
 
+#ifdef ARM_ALLOW_MULTI_CORE
+// core 0 runs the bus emulation and the menu, core 1 the job queue for file I/O (see rad_jobs.h)
+class CRADCores : public CMultiCoreSupport
+{
+public:
+	CRADCores( CMemorySystem *pMemorySystem ) : CMultiCoreSupport( pMemorySystem ) {}
+
+	void Run( unsigned nCore )
+	{
+		if ( nCore == JOB_CORE_IO )
+			jobWorker( nCore );
+	}
+};
+#endif
+
 class CRAD
 {
 public:
@@ -62,6 +82,9 @@ public:
 		m_Timer( &m_Interrupt ),
 		m_Logger( 5/*m_Options.GetLogLevel()*/, &m_Timer ),
 		m_EMMC( &m_Interrupt, &m_Timer, 0 )
+	#ifdef ARM_ALLOW_MULTI_CORE
+		, m_Cores( &m_Memory )
+	#endif
 	{
 	}
 
@@ -75,6 +98,9 @@ public:
 		logger = &m_Logger;
 		#endif
 		STANDARD_SETUP_TIMER_INTERRUPT_CYCLECOUNTER_GPIO
+		#ifdef ARM_ALLOW_MULTI_CORE
+		if ( bOK ) bOK = m_Cores.Initialize();
+		#endif
 		return bOK;
 	}
 
@@ -93,6 +119,9 @@ private:
 	CLogger				m_Logger;
 	CScheduler			m_Scheduler;
 	CEMMCDevice			m_EMMC;
+#ifdef ARM_ALLOW_MULTI_CORE
+	CRADCores			m_Cores;
+#endif
 };
 
 #endif
@@ -27,12 +27,23 @@
 
 */
 #include "rad_reu.h"
+#include "reu_trace.h"
+#include "reu_prefetch.h"
+#include "reu_pages.h"
+#include "reu_loader.h"
+#include "reu_profile.h"
+#include "fingerprint.h"
 #include "linux/kernel.h"
 
 u32 REU_SIZE_KB = 1024;
 
 REUSTATE reu AAA;
 u8 *reuMemory;
+
+// reads from non-existing REU memory return $ff, writes are dropped
+static u8 reuOpenBus[ 128 ] AAA;
+static u8 reuWriteSink[ 128 ] AAA;
+
 bool reuRunning;
 
 static u64 armCycleCounter;
@@ -62,6 +73,9 @@ void resetREU()
 	reu.contiguousWrite = 0;
 	reu.contiguousVerify = 0;
 	reu.contiguous1ByteWrites = 0;
+
+	reu.pfBase = reu.addrREU | ( (u32)reu.bank << 16 );
+	reu.pfLength = reu.length;
 }
 
 void initializeDMATimings()
@@ -96,6 +110,9 @@ void initREU( void *mempool )
 {
 	reuMemory = (u8*)mempool;
 
+	for ( u32 i = 0; i < sizeof( reuOpenBus ); i++ )
+		reuOpenBus[ i ] = 0xff;
+
 	reu.reuSize = REU_SIZE_KB * 1024;
 
 	reu.wrapAround = 0x80000; 
@@ -122,6 +139,8 @@ void initREU( void *mempool )
 		break;
 	}
 
+	reuPagesReset( reu.reuSize );
+
 	resetREU();
 	initializeDMATimings();
 }
@@ -195,7 +214,8 @@ __attribute__( ( always_inline ) ) inline u32 REU_GET_NEXT_ADDRESS( u32 r_a )
     return (r_a & 0x00f80000) | next;
 }
 
-#define REU_INCREMENT_C64ADDRESS( a ) { a = ( a + reu.incrC64 ) & 0xffff; }
+// incrC64 is the copy of reu.incrC64 which handle_transfer.h keeps in a register
+#define REU_INCREMENT_C64ADDRESS( a ) { a = ( a + incrC64 ) & 0xffff; }
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
@@ -239,6 +259,160 @@ __attribute__( ( always_inline ) ) inline void reuPrefetchW( u32 reu_addr )
 	CACHE_PRELOADL1STRMW( &reuMemory[ ( reu_addr&~63 ) & ( reu.wrapAroundDRAM - 1 ) ] );
 }
 
+// transfers are split into segments in which the REU address advances linearly (no wrap-around of
+// the address or the DRAM index) and which are either completely inside or outside of the REU memory
+// => inside a segment the transfer loops only increment a pointer by 'step' (0 for fixed addresses)
+__attribute__( ( always_inline ) ) inline u32 reuSegment( u32 r_a, u32 l, u8 *&src, u8 *&dst, u32 &step )
+{
+	u32 idx = r_a & ( reu.wrapAroundDRAM - 1 );
+	u32 seg = l, d;
+
+	if ( idx < reu.reuSize )
+	{
+		src = dst = &reuMemory[ idx ];
+		step = reu.incrREU;
+		d = reu.reuSize - idx;
+	} else
+	{
+		src = reuOpenBus;
+		dst = reuWriteSink;
+		step = 0;
+		d = reu.wrapAroundDRAM - idx;
+	}
+
+	if ( reu.incrREU )
+	{
+		if ( d < seg ) seg = d;
+		u32 low = r_a & 0x0007ffff;
+		d = ( low < reu.wrapAround ? reu.wrapAround : 0x80000 ) - low;
+		if ( d < seg ) seg = d;
+	}
+
+	return seg;
+}
+
+// the idle cycles preload the window given by the REU registers while they are written...
+__attribute__( ( always_inline ) ) inline void reuPrefetchRegisters()
+{
+	reu.pfBase = reu.addrREU | ( (u32)reu.bank << 16 );
+	reu.pfLength = reu.length;
+	reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+}
+
+// ... and after a transfer the predicted window of the next one (adaptive) or the continuation of the registers (linear)
+__attribute__( ( always_inline ) ) inline void reuPrefetchAfterTransfer( u32 base, u32 length )
+{
+	if ( reuPrefetchState.enabled )
+	{
+		reuPrefetchLearn( base, length );
+		reu.pfBase = reuPrefetchState.predBase;
+		reu.pfLength = reuPrefetchState.predLength > 0xffff ? 0xffff : reuPrefetchState.predLength;
+		reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+	} else
+	{
+		// no history is kept in linear mode, only the hits are counted
+		reuPrefetchCountHit( base );
+		reu.pfBase = reuPrefetchState.predBase = reu.addrREU | ( (u32)reu.bank << 16 );
+		reu.pfLength = reuPrefetchState.predLength = reu.length;
+	}
+}
+
+// REU address after n (>= 1) bytes of a segment starting at r_a
+__attribute__( ( always_inline ) ) inline u32 reuSegmentEnd( u32 r_a, u32 n )
+{
+	return REU_GET_NEXT_ADDRESS( r_a + ( n - 1 ) * reu.incrREU );
+}
+
+// stalls a transfer (after DMA has been triggered) until the loader core has read all banks it touches
+__attribute__( ( always_inline ) ) inline void reuWaitForBanks( u32 r_a, u32 l )
+{
+	register u32 g2;
+	u8 *src, *dst;
+	u32 step;
+
+	while ( l )
+	{
+		u32 seg = reuSegment( r_a, l, src, dst, step );
+		if ( src != reuOpenBus )
+		{
+			u32 idx = src - reuMemory;
+			u32 last = ( idx + ( seg - 1 ) * step ) >> REU_BANK_SHIFT;
+			for ( u32 b = idx >> REU_BANK_SHIFT; b <= last; b++ )
+				while ( !reuBankPresent( b ) )
+				{
+					reuLoader.wanted = b;
+					reuLoader.stalls ++;
+					WAIT_FOR_CPU_HALFCYCLE
+					WAIT_FOR_VIC_HALFCYCLE
+					RESTART_CYCLE_COUNTER
+				}
+		}
+		r_a = reuSegmentEnd( r_a, seg );
+		l -= seg;
+	}
+
+	// pairs with the barrier of the loader core between bank data and present bit
+	MEMORY_BARRIER
+}
+
+// zero-fills the pages a transfer touches which have not been filled in the idle cycles yet: this is done
+// after DMA has been triggered, the C64 waits one cycle for every REU_PAGE_FILL_PER_CYCLE bytes
+__attribute__( ( always_inline ) ) inline void reuFillPages( u32 r_a, u32 l )
+{
+	register u32 g2;
+	u8 *src, *dst;
+	u32 step;
+
+	while ( l )
+	{
+		u32 seg = reuSegment( r_a, l, src, dst, step );
+		if ( src != reuOpenBus )
+		{
+			u32 idx = src - reuMemory;
+			u32 last = ( idx + ( seg - 1 ) * step ) >> REU_PAGE_SHIFT;
+			for ( u32 p = idx >> REU_PAGE_SHIFT; p <= last; p++ )
+				if ( reuPages.state[ p ] & REU_PAGE_UNFILLED )
+				{
+					for ( u32 o = 0; o < REU_PAGE_SIZE; o += 64 )
+					{
+						CACHE_ZEROLINE( &reuMemory[ ( p << REU_PAGE_SHIFT ) + o ] );
+						if ( ( o & ( REU_PAGE_FILL_PER_CYCLE - 1 ) ) == REU_PAGE_FILL_PER_CYCLE - 64 )
+						{
+							WAIT_FOR_CPU_HALFCYCLE
+							WAIT_FOR_VIC_HALFCYCLE
+							RESTART_CYCLE_COUNTER
+						}
+					}
+					reuPages.state[ p ] &= ~REU_PAGE_UNFILLED;
+					reuPages.unfilled --;
+				}
+		}
+		r_a = reuSegmentEnd( r_a, seg );
+		l -= seg;
+	}
+}
+
+// marks the pages written by a stash or swap
+__attribute__( ( always_inline ) ) inline void reuDirtyPages( u32 r_a, u32 l )
+{
+	u8 *src, *dst;
+	u32 step;
+
+	while ( l )
+	{
+		u32 seg = reuSegment( r_a, l, src, dst, step );
+		if ( src != reuOpenBus )
+		{
+			u32 idx = src - reuMemory;
+			u32 last = ( idx + ( seg - 1 ) * step ) >> REU_PAGE_SHIFT;
+			for ( u32 p = idx >> REU_PAGE_SHIFT; p <= last; p++ )
+				reuPages.state[ p ] = REU_PAGE_DIRTY;
+		}
+		r_a = reuSegmentEnd( r_a, seg );
+		l -= seg;
+	}
+}
+
 
 #if 1
 __attribute__( ( optimize( "align-functions=256" ) ) )
@@ -249,11 +423,11 @@ u8 reuUsingPolling( int step )
 	register u16 resetCount = 0;
 
 	u16 ipl = 0;
+	u32 iplSize = REU_POLLING_CODE_SIZE;
 
 	if ( step <= 1 )
 	{
-		void *p = ( && reuEmulationMainLoop );
-		CACHE_PRELOAD_INSTRUCTION_CACHE( p, 0x1a00 );
+		CACHE_PRELOAD_INSTRUCTION_CACHE( __start_section_polling, iplSize );
 
 		if ( step == 1 ) return 0;
 
@@ -266,7 +440,9 @@ u8 reuUsingPolling( int step )
 		SET_GPIO( bDMA_OUT );
 	}
 
-reuEmulationMainLoop:
+#ifdef PERF_HEADROOM
+	perfHeadroomReset();
+#endif
 
 	CLR_GPIO( bMPLEX_SEL );
 	WAIT_FOR_CPU_HALFCYCLE
@@ -276,9 +452,9 @@ reuEmulationMainLoop:
 	{
 		WAIT_FOR_VIC_HALFCYCLE
 
-		void *p = (u8*)( && reuEmulationMainLoop ) + ipl;
+		void *p = __start_section_polling + ipl;
 		CACHE_PRELOADIKEEP( p );
-		ipl += 64; if ( ipl >= 0x1a00 ) ipl = 0;
+		ipl += 64; if ( ipl >= iplSize ) ipl = 0;
 
 		if ( CPU_RESET )
 		{
@@ -294,12 +470,12 @@ reuEmulationMainLoop:
 		SET_GPIO( bDIR_Dx );
 		WAIT_FOR_CPU_HALFCYCLE
 		RESTART_CYCLE_COUNTER
-		WAIT_UP_TO_CYCLE( reu.WAIT_FOR_SIGNALS + reu.TIMING_OFFSET_CBTD );
+		WAIT_UP_TO_CYCLE_SITE( reu.WAIT_FOR_SIGNALS + reu.TIMING_OFFSET_CBTD, PERF_SITE_SIGNALS );
 		g2 = read32( ARM_GPIO_GPLEV0 );
 
 		SET_GPIO( bMPLEX_SEL );
 
-		WAIT_UP_TO_CYCLE( reu.WAIT_CYCLE_MULTIPLEXER );
+		WAIT_UP_TO_CYCLE_SITE( reu.WAIT_CYCLE_MULTIPLEXER, PERF_SITE_MULTIPLEXER );
 		g3 = read32( ARM_GPIO_GPLEV0 );
 		CLR_GPIO( bMPLEX_SEL );
 
@@ -320,7 +496,7 @@ reuEmulationMainLoop:
 				SET_BANK2_INPUT
 				///SET_GPIO( bDIR_Dx );
 				CLR_GPIO( bOE_Dx );				// Dx = enable
-				WAIT_UP_TO_CYCLE( reu.WAIT_CYCLE_WRITEDATA );
+				WAIT_UP_TO_CYCLE_SITE( reu.WAIT_CYCLE_WRITEDATA, PERF_SITE_WRITEDATA );
 				D = ( read32( ARM_GPIO_GPLEV0 ) >> D0 ) & 255;
 				SET_GPIO( bOE_Dx );				// Dx = disable
 				SET_BANK2_OUTPUT
@@ -360,23 +536,23 @@ reuEmulationMainLoop:
 						break;
 					case 0x04:
 						reu.addrREU = reu.shadow_addrREU = ( reu.shadow_addrREU & 0xff00 ) | D;
-						reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+						reuPrefetchRegisters();
 						break;
 					case 0x05:
 						reu.addrREU = reu.shadow_addrREU = ( reu.shadow_addrREU & 0x00ff ) | ( D << 8 );
-						reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+						reuPrefetchRegisters();
 						break;
 					case 0x06:
 						reu.bank = reu.shadow_bank = D & ~reu.regBankUnused;
-						reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+						reuPrefetchRegisters();
 						break;
 					case 0x07:
 						reu.length = reu.shadow_length = ( reu.shadow_length & 0xff00 ) | D;
-						reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+						reuPrefetchRegisters();
 						break;
 					case 0x08:
 						reu.length = reu.shadow_length = ( reu.shadow_length & 0x00ff ) | ( D << 8 );
-						reu.pl = reu.CACHING_L2_OFFSET_KB; reu.pl2 = 0;
+						reuPrefetchRegisters();
 						break;
 					case 0x09:
 						reu.IRQmask = D | REU_INTERRUPT_UNUSED_BITMASK;
@@ -451,7 +627,7 @@ reuEmulationMainLoop:
 						INP_GPIO_IRQ();
 					}
 
-				WAIT_UP_TO_CYCLE( reu.WAIT_CYCLE_READ2 );
+				WAIT_UP_TO_CYCLE_SITE( reu.WAIT_CYCLE_READ2, PERF_SITE_READ2 );
 				SET_GPIO( bOE_Dx | bDIR_Dx );
 			}
 
@@ -468,13 +644,23 @@ reuEmulationMainLoop:
 		// changing anything below might make everything less stable
 		for ( int i = 0; i < reu.CACHING_L2_PRELOADS_PER_CYCLE; i++ )
 		{
-			reuPrefetch( ( reu.addrREU | ( (u32)reu.bank << 16 ) ) + reu.pl );
+			reuPrefetch( reu.pfBase + reu.pl );
 			reu.pl += 64;
-			if ( reu.pl >= reu.length + 64 ) reu.pl = 0;
+			if ( reu.pl >= reu.pfLength + 64 ) reu.pl = 0;
 		}
 
-		CACHE_PRELOADL1STRM( &reuMemory[ ( ( ( reu.pl2 + reu.addrREU ) | ( (u32)reu.bank << 16 ) ) & ~63 ) & ( reu.reuSize - 1 ) ] );
-		reu.pl2 += 64; if ( reu.pl2 >= min( reu.CACHING_L1_WINDOW_KB - 64, reu.length ) ) reu.pl2 = 0;
+		CACHE_PRELOADL1STRM( &reuMemory[ ( ( reu.pfBase + reu.pl2 ) & ~63 ) & ( reu.reuSize - 1 ) ] );
+		reu.pl2 += 64; if ( reu.pl2 >= min( reu.CACHING_L1_WINDOW_KB - 64, reu.pfLength ) ) reu.pl2 = 0;
+
+		if ( reuPages.unfilled )
+			reuPagesFillStep( reuMemory );
+
+		if ( reuLoader.profilePending )
+		{
+			reuLoader.profilePending = 0;
+			MEMORY_BARRIER
+			reuProfileApply( reuImageFingerprint );
+		}
 
 		forceRead = reuLoad32( 0 );
 	}
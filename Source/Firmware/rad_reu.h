@@ -84,6 +84,7 @@
 
 #define SPECIAL_NUVIE		0x01
 #define SPECIAL_BLUREU		0x02
+#define SPECIAL_NO_VERIFY_HACK	0x04	// REU tests are not detected (see handle_transfer.h)
 
 #pragma pack(push)
 #pragma pack(1)
@@ -154,7 +155,9 @@ typedef struct
 		TIMING_RW_BEFORE_ADDR,
 		TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING_MINUS_RW_BEFORE_ADDR;
 // 122		
-	u8 padding[ 6 ];
+	// REU window preloaded in idle cycles (see reu_prefetch.h)
+	u32 pfBase;
+	u16 pfLength;
 } __attribute__((packed)) REUSTATE;
 #pragma pack(pop)
 
@@ -167,5 +170,10 @@ extern REUSTATE reu AAA;
 extern void resetREU();
 extern void initREU( void *mempool );
 extern __attribute__((optimize("align-functions=256"))) void FIQHandlerREU( void *pParam );
-extern u8 reuUsingPolling();
+extern u8 reuUsingPolling( int step = 0 );
+
+// reuUsingPolling is the only code in section_polling, the linker provides the bounds of the section
+// => the instruction cache warm-up covers exactly the polling loop, however large it is compiled
+extern u8 __start_section_polling[], __stop_section_polling[];
+#define REU_POLLING_CODE_SIZE	( (u32)( __stop_section_polling - __start_section_polling ) )
 
@@ -0,0 +1,237 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - streaming REU image loader (runs on a secondary core)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "helpers.h"
+#include "rad_jobs.h"
+#include "rad_reu.h"
+#include "reu_pages.h"
+#include "reu_loader.h"
+#include "lz_image.h"
+#include "crc32.h"
+#include "fingerprint.h"
+
+REULOADER reuLoader AAA;
+
+static CLogger *loaderLogger;
+static const char *loaderDrive;
+static u8 lzBlock[ LZIMAGE_BLOCK_SIZE ] AAA;
+
+// reads bank b of the image (result is the state of the file, a bank after an error is zero-filled)
+static u32 reuLoaderReadBank( CLogger *logger, FIL *file, u32 result, u32 b )
+{
+	u8 *d = &reuLoader.mem[ b << REU_BANK_SHIFT ];
+	u32 n = min( (u32)REU_BANK_SIZE, reuLoader.size - ( b << REU_BANK_SHIFT ) );
+	u32 l = reuLoader.length[ b ];
+	u32 nBytesRead;
+
+	if ( result == FR_OK )
+		result = f_lseek( file, reuLoader.fileOfs[ b ] );
+
+	if ( result == FR_OK )
+	{
+		if ( l == n )
+			result = f_read( file, d, n, &nBytesRead ); else
+		if ( ( result = f_read( file, lzBlock, l, &nBytesRead ) ) == FR_OK && !lzDecompressBlock( lzBlock, l, d, n ) )
+		{
+			logger->Write( "RAD", LogError, "Corrupt block %d in %s", b, reuLoader.image );
+			memset( d, 0, n );
+			reuLoader.readErrors ++;
+		}
+
+		if ( result != FR_OK )
+			logger->Write( "RAD", LogError, "Read error" );
+	}
+
+	if ( result != FR_OK )
+	{
+		memset( d, 0, n );
+		reuLoader.readErrors ++;
+	}
+
+	// the fingerprint is computed from the file data, before the emulation can modify the bank
+	if ( !reuLoader.fingerprintKnown )
+		reuLoader.crc[ b ] = ~crc32Update( 0xffffffff, d, n );
+
+	// the bank data has to be visible to the emulation before its present bit
+	MEMORY_BARRIER
+	reuLoader.present[ b >> 5 ] |= 1 << ( b & 31 );
+	reuLoader.missing --;
+
+	return result;
+}
+
+// reads the missing banks, a bank a transfer waits for (reuLoader.wanted) goes first
+static void reuLoaderRead( void *param )
+{
+	CLogger *logger = loaderLogger;
+
+	// mount file system
+	if ( fsMount( loaderDrive ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", loaderDrive );
+
+	FIL file;
+	u32 result = f_open( &file, reuLoader.image, FA_READ | FA_OPEN_EXISTING );
+	u32 next = 0;
+
+	while ( reuLoader.missing )
+	{
+		u32 b = reuLoader.wanted;
+		if ( b >= reuLoader.nBanks || reuBankPresent( b ) )
+		{
+			while ( reuBankPresent( next ) )
+				next ++;
+			b = next;
+		}
+
+		result = reuLoaderReadBank( logger, &file, result, b );
+	}
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	// an image loaded for the first time: its profile is applied by the polling loop (between two C64 cycles)
+	if ( !reuLoader.fingerprintKnown )
+	{
+		u32 fingerprint = 0;
+		for ( u32 b = 0; b < reuLoader.nBanks; b++ )
+			fingerprint = crc32Combine( fingerprint, reuLoader.crc[ b ], min( (u32)REU_BANK_SIZE, reuLoader.size - ( b << REU_BANK_SHIFT ) ) );
+
+		// not recorded after a read error, it would be wrong for good
+		if ( !reuLoader.readErrors )
+			fingerprintStore( logger, reuLoader.image, fingerprint, reuImageSpecial );
+		reuImageFingerprint = fingerprint;
+		MEMORY_BARRIER
+		reuLoader.profilePending = 1;
+	}
+}
+
+int reuLoaderStart( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *mem, u32 *size )
+{
+	jobWait( JOB_CORE_IO );
+	memset( (void*)&reuLoader, 0, sizeof( REULOADER ) );
+	loaderLogger = logger;
+	loaderDrive = DRIVE;
+	reuLoader.mem = mem;
+	reuImageFingerprint = reuImageSpecial = 0;
+	strncpy( reuLoader.image, FILENAME, sizeof( reuLoader.image ) - 1 );
+	*size = 0;
+
+	// mount file system
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	// open file
+	FIL file;
+	u32 result = f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING );
+	if ( result != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
+
+		reuPagesLoaded( mem, 0, NULL );
+		return 0;
+	}
+
+	// a known image: its profile is applied when the emulation starts
+	reuLoader.fingerprintKnown = fingerprintLookup( FILENAME, &reuImageFingerprint, &reuImageSpecial );
+
+	// file offset and stored length of every bank
+	if ( lzIsCompressedImage( FILENAME ) )
+	{
+		LZIMAGEHEADER h;
+		u32 nBytesRead;
+		result = f_read( &file, &h, sizeof( LZIMAGEHEADER ), &nBytesRead );
+
+		if ( result != FR_OK || nBytesRead != sizeof( LZIMAGEHEADER ) || h.magic != LZIMAGE_MAGIC || h.blockShift != REU_BANK_SHIFT ||
+			 h.nBlocks > REU_BANKS_MAX || h.size > ( h.nBlocks << REU_BANK_SHIFT ) ||
+			 f_read( &file, reuLoader.length, h.nBlocks * sizeof( u32 ), &nBytesRead ) != FR_OK || nBytesRead != h.nBlocks * sizeof( u32 ) )
+		{
+			logger->Write( "RAD", LogError, "Not a compressed image: %s", FILENAME );
+			h.nBlocks = h.size = 0;
+		}
+
+		u32 ofs = sizeof( LZIMAGEHEADER ) + h.nBlocks * sizeof( u32 );
+		for ( u32 i = 0; i < h.nBlocks; i++ )
+		{
+			if ( reuLoader.length[ i ] > LZIMAGE_BLOCK_SIZE )
+			{
+				logger->Write( "RAD", LogError, "Corrupt block %d in %s", i, FILENAME );
+				h.size = min( h.size, i << REU_BANK_SHIFT );
+				break;
+			}
+			reuLoader.fileOfs[ i ] = ofs;
+			ofs += reuLoader.length[ i ];
+		}
+
+		reuLoader.size = h.size;
+		reuLoader.compressed = 1;
+	} else
+	{
+		reuLoader.size = min( (u32)f_size( &file ), (u32)REU_BANKS_MAX << REU_BANK_SHIFT );
+		for ( u32 i = 0; i << REU_BANK_SHIFT < reuLoader.size; i++ )
+		{
+			reuLoader.fileOfs[ i ] = i << REU_BANK_SHIFT;
+			reuLoader.length[ i ] = min( (u32)REU_BANK_SIZE, reuLoader.size - ( i << REU_BANK_SHIFT ) );
+		}
+	}
+
+	*size = reuLoader.size;
+	reuLoader.nBanks = ( reuLoader.size + REU_BANK_SIZE - 1 ) >> REU_BANK_SHIFT;
+
+	// banks beyond the image and all-zero blocks of .reuz images are never read (the latter are zero-filled lazily)
+	reuPagesLoaded( mem, reuLoader.size, FILENAME );
+	for ( u32 i = 0; i < REU_BANKS_MAX; i++ )
+		if ( i >= reuLoader.nBanks || ( reuLoader.compressed && reuLoader.length[ i ] == 0 ) )
+		{
+			if ( i < reuLoader.nBanks )
+			{
+				reuPagesSetZero( i << REU_BANK_SHIFT, REU_BANK_SIZE );
+				reuLoader.crc[ i ] = crc32Zeros( min( (u32)REU_BANK_SIZE, reuLoader.size - ( i << REU_BANK_SHIFT ) ) );
+			}
+			reuLoader.present[ i >> 5 ] |= 1 << ( i & 31 );
+		} else
+			reuLoader.missing ++;
+
+	// an unknown image: the banks with the NUVIE signatures are read before the emulation starts, the result is
+	// recorded with the fingerprint
+	if ( !reuLoader.fingerprintKnown )
+	{
+		const u32 signatureBank[ 2 ] = { 0x00, 0x8f };
+		for ( u32 i = 0; i < 2; i++ )
+			if ( !reuBankPresent( signatureBank[ i ] ) )
+				result = reuLoaderReadBank( logger, &file, result, signatureBank[ i ] );
+		reuImageSpecial = reuImageIsNuvie( mem, reuLoader.size );
+	}
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	jobPost( JOB_CORE_IO, reuLoaderRead, 0 );
+
+	return 1;
+}
@@ -0,0 +1,81 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - streaming REU image loader (runs on a secondary core)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _reu_loader_h
+#define _reu_loader_h
+
+#include <circle/types.h>
+#include "lowlevel_arm64.h"
+
+// a selected REU image is read by the I/O core while the REU emulation is already running: the image is loaded
+// in banks of 64 KB (the block size of .reuz images), lowest bank first unless a transfer stalls waiting for another
+// one; transfers only check the present bits while banks are still missing (see reuWaitForBanks in rad_reu.cpp)
+#define REU_BANK_SHIFT		16
+#define REU_BANK_SIZE		( 1 << REU_BANK_SHIFT )
+#define REU_BANKS_MAX		( 16384 * 1024 / REU_BANK_SIZE )
+
+typedef struct
+{
+	// written by the loader core only (after the bank data), except when starting
+	volatile u32 present[ REU_BANKS_MAX / 32 ];
+	volatile u32 missing;
+
+	// written by the emulation: the bank a stalled transfer waits for, loaded next
+	volatile u32 wanted;
+
+	// set by the loader core when the fingerprint of a new image is known, the polling loop applies the profile
+	// (see reu_profile.h) when no REU access is in progress and clears it
+	volatile u32 profilePending;
+
+	u32 stalls;			// C64 cycles transfers waited for the loader
+	u32 readErrors;		// banks which have been zero-filled instead
+
+	u8  *mem;
+	u32 size, nBanks, compressed;
+	u32 fingerprintKnown;
+	u32 fileOfs[ REU_BANKS_MAX ], length[ REU_BANKS_MAX ];
+	u32 crc[ REU_BANKS_MAX ];	// CRC-32 of the bank as read from the file, combined to the fingerprint (see fingerprint.h)
+	char image[ 1024 ];
+} REULOADER;
+
+extern REULOADER reuLoader AAA;
+
+__attribute__( ( always_inline ) ) inline u32 reuBankPresent( u32 bank )
+{
+	return reuLoader.present[ bank >> 5 ] & ( 1 << ( bank & 31 ) );
+}
+
+#ifndef RAD_HOST_SIMULATION
+#include <circle/logger.h>
+
+// reads size (and block table of .reuz images), and posts the loading as a job for the I/O core (see rad_jobs.h);
+// jobWait( JOB_CORE_IO ) blocks until the image has been loaded completely
+extern int reuLoaderStart( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *mem, u32 *size );
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - REU page table: lazy zero-fill and tracking of modified memory
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "reu_pages.h"
+
+REUPAGES reuPages AAA;
+
+// a fresh REU: all pages are zero, but instead of clearing the memory upfront this is done
+// in the idle cycles of the polling loop, or when a transfer touches a page first
+void reuPagesReset( u32 size )
+{
+	reuPages.nPages = ( size + REU_PAGE_SIZE - 1 ) >> REU_PAGE_SHIFT;
+	memset( reuPages.state, REU_PAGE_ZERO | REU_PAGE_UNFILLED, reuPages.nPages );
+	reuPages.unfilled = reuPages.nPages;
+	reuPages.fillPage = reuPages.fillOfs = 0;
+	reuPages.image[ 0 ] = 0;
+}
+
+// an image (or snapshot, then image is NULL) has been loaded to the first 'size' bytes, the remainder of the REU is zero
+void reuPagesLoaded( u8 *mem, u32 size, const char *image )
+{
+	reuPages.image[ 0 ] = 0;
+	if ( image )
+	{
+		strncpy( reuPages.image, image, 1023 );
+		reuPages.image[ 1023 ] = 0;
+	}
+
+	u32 n = ( size + REU_PAGE_SIZE - 1 ) >> REU_PAGE_SHIFT;
+	if ( n > reuPages.nPages )
+		n = reuPages.nPages;
+
+	for ( u32 i = 0; i < n; i++ )
+	{
+		if ( reuPages.state[ i ] & REU_PAGE_UNFILLED )
+			reuPages.unfilled --;
+		reuPages.state[ i ] = 0;
+	}
+
+	// clear the rest of a partially loaded page
+	if ( size < ( n << REU_PAGE_SHIFT ) )
+		memset( &mem[ size ], 0, ( n << REU_PAGE_SHIFT ) - size );
+}
+
+// pages which are all zero in a loaded image (see readFileLZ) are left to the lazy zero-fill
+void reuPagesSetZero( u32 ofs, u32 size )
+{
+	for ( u32 i = ofs >> REU_PAGE_SHIFT; i < ( ( ofs + size ) >> REU_PAGE_SHIFT ) && i < reuPages.nPages; i++ )
+		if ( !( reuPages.state[ i ] & REU_PAGE_UNFILLED ) )
+		{
+			reuPages.state[ i ] = REU_PAGE_ZERO | REU_PAGE_UNFILLED;
+			reuPages.unfilled ++;
+		}
+	reuPages.fillPage = reuPages.fillOfs = 0;
+}
+
+// zero-fills all remaining pages, before the memory is accessed outside of the polling loop
+void reuPagesFlush( u8 *mem )
+{
+	for ( u32 i = 0; reuPages.unfilled && i < reuPages.nPages; i++ )
+		if ( reuPages.state[ i ] & REU_PAGE_UNFILLED )
+		{
+			memset( &mem[ i << REU_PAGE_SHIFT ], 0, REU_PAGE_SIZE );
+			reuPages.state[ i ] &= ~REU_PAGE_UNFILLED;
+			reuPages.unfilled --;
+		}
+}
+
+// the memory has been written to an image, from now on saving to this file only needs to rewrite the dirty pages
+void reuPagesSaved( const char *image )
+{
+	strncpy( reuPages.image, image, 1023 );
+	reuPages.image[ 1023 ] = 0;
+
+	for ( u32 i = 0; i < reuPages.nPages; i++ )
+		reuPages.state[ i ] &= ~REU_PAGE_DIRTY;
+}
+
+u32 reuPagesCount( u8 mask )
+{
+	u32 n = 0;
+	for ( u32 i = 0; i < reuPages.nPages; i++ )
+		if ( reuPages.state[ i ] & mask )
+			n ++;
+	return n;
+}
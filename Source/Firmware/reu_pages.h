@@ -0,0 +1,90 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - REU page table: lazy zero-fill and tracking of modified memory
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _reu_pages_h
+#define _reu_pages_h
+
+#include <circle/types.h>
+#include "lowlevel_arm64.h"
+
+#define REU_PAGE_SHIFT			12
+#define REU_PAGE_SIZE			( 1 << REU_PAGE_SHIFT )
+#define REU_PAGES_MAX			( 16384 * 1024 / REU_PAGE_SIZE )
+#define REU_PAGE_FILL_PER_CYCLE	1024	// bytes zero-filled per C64 cycle when a transfer touches an unfilled page
+
+// page state bits
+#define REU_PAGE_DIRTY			1		// written by a transfer since the image has been loaded or saved
+#define REU_PAGE_ZERO			2		// content is all zero
+#define REU_PAGE_UNFILLED		4		// ... but the memory has not been zero-filled yet
+
+typedef struct
+{
+	u8  state[ REU_PAGES_MAX ];
+	u32 nPages;
+
+	// number of unfilled pages, and the page/offset the idle cycles zero-fill next
+	u32 unfilled;
+	u32 fillPage, fillOfs;
+
+	// image file which the clean pages correspond to (empty for a fresh REU)
+	char image[ 1024 ];
+} REUPAGES;
+
+extern REUPAGES reuPages AAA;
+
+extern void reuPagesReset( u32 size );
+extern void reuPagesLoaded( u8 *mem, u32 size, const char *image );
+extern void reuPagesSetZero( u32 ofs, u32 size );
+extern void reuPagesFlush( u8 *mem );
+extern void reuPagesSaved( const char *image );
+extern u32 reuPagesCount( u8 mask );
+
+// zero-fills one cache line of the next unfilled page, called in the idle cycles of the polling loop
+__attribute__( ( always_inline ) ) inline void reuPagesFillStep( u8 *mem )
+{
+	REUPAGES &p = reuPages;
+
+	if ( !( p.state[ p.fillPage ] & REU_PAGE_UNFILLED ) )
+	{
+		// already filled when a transfer touched it
+		p.fillPage ++; p.fillOfs = 0;
+		return;
+	}
+
+	CACHE_ZEROLINE( &mem[ ( p.fillPage << REU_PAGE_SHIFT ) + p.fillOfs ] );
+	p.fillOfs += 64;
+
+	if ( p.fillOfs == REU_PAGE_SIZE )
+	{
+		p.state[ p.fillPage ++ ] &= ~REU_PAGE_UNFILLED;
+		p.fillOfs = 0;
+		p.unfilled --;
+	}
+}
+
+#endif
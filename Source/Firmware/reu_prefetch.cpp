@@ -0,0 +1,80 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - adaptive preloading: predicts the REU window of the next transfer from the last ones
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include <circle/util.h>
+#include "lowlevel_arm64.h"
+#include "reu_prefetch.h"
+
+// "REU_PREFETCH ADAPTIVE|LINEAR" in rad.cfg, overridden for single images with
+// "REU_PREFETCH_ADAPTIVE|REU_PREFETCH_LINEAR "filename""
+u32 reuPrefetchAdaptive = 0;
+
+static char prefetchImage[ REU_PREFETCH_IMAGES ][ 64 ];
+static u8 prefetchImageAdaptive[ REU_PREFETCH_IMAGES ];
+static u32 nPrefetchImages = 0;
+
+REUPREFETCH reuPrefetchState AAA;
+
+void reuPrefetchSetImage( const char *name, u32 adaptive )
+{
+	if ( nPrefetchImages >= REU_PREFETCH_IMAGES )
+		return;
+	strncpy( prefetchImage[ nPrefetchImages ], name, 63 );
+	prefetchImage[ nPrefetchImages ][ 63 ] = 0;
+	prefetchImageAdaptive[ nPrefetchImages ++ ] = adaptive;
+}
+
+// called when starting the REU emulation with the image (path) it uses or NULL
+void reuPrefetchReset( const char *image )
+{
+	memset( &reuPrefetchState, 0, sizeof( REUPREFETCH ) );
+	reuPrefetchState.enabled = reuPrefetchAdaptive;
+
+	if ( image )
+	{
+		const char *t = strrchr( image, '/' );
+		t = t ? t + 1 : image;
+		for ( u32 i = 0; i < nPrefetchImages; i++ )
+			if ( strcasecmp( t, prefetchImage[ i ] ) == 0 )
+				reuPrefetchState.enabled = prefetchImageAdaptive[ i ];
+	}
+}
+
+// called when entering the menu
+void reuPrefetchReport( CLogger *logger )
+{
+	REUPREFETCH &p = reuPrefetchState;
+	if ( p.predicted == 0 )
+		return;
+
+	logger->Write( "RAD", LogNotice, "REU preloading (%s): %d of %d transfers started in the preloaded window (%d%%)", p.enabled ? "adaptive" : "linear",
+		p.hits, p.predicted, (u32)( (u64)p.hits * 100 / p.predicted ) );
+
+	p.predicted = p.hits = 0;
+}
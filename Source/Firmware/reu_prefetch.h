@@ -0,0 +1,129 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - adaptive preloading: predicts the REU window of the next transfer from the last ones
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _reu_prefetch_h
+#define _reu_prefetch_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+#define REU_PREFETCH_HISTORY	8		// last transfers (must be a power of two)
+#define REU_PREFETCH_TABLE		64		// successor table entries (must be a power of two)
+#define REU_PREFETCH_IMAGES		16		// per-image settings in rad.cfg
+
+typedef struct
+{
+	// REU windows (bank << 16 | address, length) of the last transfers, the most recent one at head
+	u32 base[ REU_PREFETCH_HISTORY ];
+	u32 length[ REU_PREFETCH_HISTORY ];
+	u32 head;
+
+	// successor table: the window which followed a transfer at some REU address (tag = address + 1, 0 = empty)
+	u32 tag[ REU_PREFETCH_TABLE ];
+	u32 next[ REU_PREFETCH_TABLE ];
+	u32 nextLength[ REU_PREFETCH_TABLE ];
+
+	// predicted window of the next transfer (replaced by the register window if not enabled)
+	u32 predBase, predLength;
+
+	u32 enabled;
+	u32 transfers, predicted, hits;
+} REUPREFETCH;
+
+extern REUPREFETCH reuPrefetchState;
+extern u32 reuPrefetchAdaptive;
+
+extern void reuPrefetchSetImage( const char *name, u32 adaptive );
+extern void reuPrefetchReset( const char *image );
+extern void reuPrefetchReport( CLogger *logger );
+
+__attribute__( ( always_inline ) ) inline u32 reuPrefetchHash( u32 a )
+{
+	return ( a * 0x9e3779b1 ) >> 26;
+}
+
+// a hit: the transfer started inside the window which has been preloaded since the last one
+__attribute__( ( always_inline ) ) inline void reuPrefetchCountHit( u32 base )
+{
+	REUPREFETCH &p = reuPrefetchState;
+
+	if ( p.predLength )
+	{
+		p.predicted ++;
+		if ( base - p.predBase < p.predLength )
+			p.hits ++;
+	}
+}
+
+// called after each transfer with the REU window it accessed
+__attribute__( ( always_inline ) ) inline void reuPrefetchLearn( u32 base, u32 length )
+{
+	REUPREFETCH &p = reuPrefetchState;
+
+	reuPrefetchCountHit( base );
+
+	if ( p.transfers ++ )
+	{
+		u32 prev = p.base[ p.head & ( REU_PREFETCH_HISTORY - 1 ) ];
+		u32 i = reuPrefetchHash( prev );
+		p.tag[ i ] = prev + 1;
+		p.next[ i ] = base;
+		p.nextLength[ i ] = length;
+	}
+
+	p.head ++;
+	p.base[ p.head & ( REU_PREFETCH_HISTORY - 1 ) ] = base;
+	p.length[ p.head & ( REU_PREFETCH_HISTORY - 1 ) ] = length;
+
+	#define B( i ) p.base[ ( p.head - (i) ) & ( REU_PREFETCH_HISTORY - 1 ) ]
+	u32 b1 = B( 1 ), b2 = B( 2 ), b3 = B( 3 ), b5 = B( 5 );
+	#undef B
+	u32 i = reuPrefetchHash( base );
+
+	p.predLength = length;
+	if ( p.transfers >= 3 && base - b1 == b1 - b2 )
+	{
+		// constant stride between transfers (including the same window again)
+		p.predBase = base + ( base - b1 );
+	} else
+	if ( p.transfers >= 6 && b1 - b3 == b3 - b5 )
+	{
+		// every other transfer with a constant stride (e.g. NUVIE header and frames, two banks)
+		p.predBase = b1 + ( b1 - b3 );
+		p.predLength = p.length[ ( p.head - 1 ) & ( REU_PREFETCH_HISTORY - 1 ) ];
+	} else
+	if ( p.tag[ i ] == base + 1 )
+	{
+		// this transfer has been seen before (e.g. GEOS pages)
+		p.predBase = p.next[ i ];
+		p.predLength = p.nextLength[ i ];
+	} else
+		p.predBase = base + length;
+}
+
+#endif
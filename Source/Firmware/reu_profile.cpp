@@ -0,0 +1,110 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - per-title REU emulation profiles (keyed by image fingerprint)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "lowlevel_arm64.h"
+#include "rad_reu.h"
+#include "reu_prefetch.h"
+#include "fingerprint.h"
+#include "reu_profile.h"
+
+// the first entry replaces the former hardcoded detection of Blureu
+static REUPROFILE reuProfile[ REU_PROFILES_MAX ] = { { FINGERPRINT_BLUREU, SPECIAL_BLUREU, REU_PROFILE_PREFETCH_DEFAULT, 0 } };
+static u32 nREUProfiles = 1;
+
+REUPROFILE *reuProfileAdd( u32 fingerprint )
+{
+	for ( u32 i = 0; i < nREUProfiles; i++ )
+		if ( reuProfile[ i ].fingerprint == fingerprint )
+			return &reuProfile[ i ];
+
+	if ( nREUProfiles >= REU_PROFILES_MAX )
+		return NULL;
+
+	REUPROFILE *p = &reuProfile[ nREUProfiles ++ ];
+	memset( p, 0, sizeof( REUPROFILE ) );
+	p->fingerprint = fingerprint;
+	p->prefetch = REU_PROFILE_PREFETCH_DEFAULT;
+	return p;
+}
+
+// index as in timingNames (config.h), same conversions as in initializeDMATimings()
+static void reuProfileSetTiming( u32 i, u32 v )
+{
+	switch ( i )
+	{
+	case 0: reu.WAIT_FOR_SIGNALS = v; break;
+	case 1: reu.WAIT_CYCLE_READ = v; reu.WAIT_CYCLE_READ2 = v + 20; break;
+	case 2: reu.WAIT_CYCLE_WRITEDATA = v; break;
+	case 4: reu.WAIT_CYCLE_READ_VIC2 = v; break;
+	case 5: reu.WAIT_CYCLE_WRITEDATA_VIC2 = v; break;
+	case 6: reu.WAIT_CYCLE_MULTIPLEXER = v; break;
+	case 7: reu.WAIT_CYCLE_MULTIPLEXER_VIC2 = v; break;
+	case 8: reu.WAIT_TRIGGER_DMA = v; break;
+	case 9: reu.WAIT_RELEASE_DMA = v; break;
+	case 10: reu.TIMING_OFFSET_CBTD = v; break;
+	case 11: reu.TIMING_DATA_HOLD = v; break;
+	case 12: reu.TIMING_TRIGGER_DMA = v; break;
+	case 13: reu.TIMING_ENABLE_ADDRLATCH = v; break;
+	case 14: reu.TIMING_READ_BA_WRITING = v; break;
+	case 15: reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING = v; break;
+	case 16: reu.TIMING_ENABLE_DATA_WRITING = v; break;
+	case 17: reu.TIMING_BA_SIGNAL_AVAIL = v; break;
+	case 18: reu.CACHING_L1_WINDOW_KB = v * 1024; break;
+	case 19: reu.CACHING_L2_OFFSET_KB = v * 1024; break;
+	case 20: reu.CACHING_L2_PRELOADS_PER_CYCLE = v; break;
+	case 21: reu.TIMING_RW_BEFORE_ADDR = v; break;
+	default: break;
+	}
+	reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING_MINUS_RW_BEFORE_ADDR = reu.TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING - reu.TIMING_RW_BEFORE_ADDR;
+}
+
+// also called by the polling loop when the fingerprint of a new image is known only after loading it (core 0 only)
+void reuProfileApply( u32 fingerprint )
+{
+	REUPROFILE *p = NULL;
+
+	for ( u32 i = 0; i < nREUProfiles && fingerprint; i++ )
+		if ( reuProfile[ i ].fingerprint == fingerprint )
+			p = &reuProfile[ i ];
+
+	if ( !p )
+	{
+		reu.isSpecial = reuImageSpecial;
+		return;
+	}
+
+	for ( u32 i = 0; i < TIMING_NAMES; i++ )
+		if ( p->timingSet & ( 1 << i ) )
+			reuProfileSetTiming( i, p->timing[ i ] );
+
+	if ( p->prefetch != REU_PROFILE_PREFETCH_DEFAULT )
+		reuPrefetchState.enabled = p->prefetch;
+
+	reu.isSpecial = reuImageSpecial | p->special;
+}
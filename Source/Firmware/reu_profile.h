@@ -0,0 +1,63 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - per-title REU emulation profiles (keyed by image fingerprint)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _reu_profile_h
+#define _reu_profile_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "config.h"
+
+// settings for single titles, identified by the fingerprint of their REU image (see fingerprint.h), are read
+// from SD:RAD/profiles.cfg and override the global settings when the emulation starts with such an image:
+//
+//   PROFILE 2a9634da                  fingerprint as printed by "reuz -fingerprint"
+//   SPECIAL NO_VERIFY_HACK            flags (NUVIE, BLUREU, NO_VERIFY_HACK)
+//   REU_PREFETCH LINEAR               ADAPTIVE or LINEAR (see reu_prefetch.h)
+//   CACHING_L1_WINDOW_KB 16           any of the timing/caching values of rad.cfg
+//
+#define FILENAME_PROFILES		"SD:RAD/profiles.cfg"
+#define REU_PROFILES_MAX		64
+
+#define REU_PROFILE_PREFETCH_DEFAULT	0xff
+
+typedef struct
+{
+	u32 fingerprint;
+	u8  special, prefetch;
+	u32 timingSet;					// bit i: timing[ i ] replaces the value of timingNames[ i ]
+	u16 timing[ TIMING_NAMES ];
+} REUPROFILE;
+
+extern REUPROFILE *reuProfileAdd( u32 fingerprint );
+
+// sets reu.isSpecial (the profile's flags and reuImageSpecial) and the REU timing copy for the image with this
+// fingerprint (0 = none), after initREU() and reuPrefetchReset(); core 0 only, as it changes the state of the polling loop
+extern void reuProfileApply( u32 fingerprint );
+
+#endif
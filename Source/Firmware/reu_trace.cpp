@@ -0,0 +1,70 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - runtime trace of REU transfers (ring buffer, written to SD:RAD/reutrace.bin)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "lowlevel_arm64.h"
+#include "helpers.h"
+#include "rad_reu.h"
+#include "reu_trace.h"
+
+static const char FILENAME_REU_TRACE[] = "SD:RAD/reutrace.bin";
+
+// switched on with "REU_TRACE ON" in rad.cfg
+u32 reuTraceEnabled = 0;
+
+REUTRACE reuTrace AAA;
+
+void reuTraceReset( const char *title )
+{
+	memset( &reuTrace.h, 0, sizeof( REUTRACEHEADER ) );
+	reuTrace.h.magic = REU_TRACE_MAGIC;
+	reuTrace.h.version = REU_TRACE_VERSION;
+	reuTrace.h.nEntries = REU_TRACE_ENTRIES;
+	reuTrace.h.timeShift = REU_TRACE_TIME_SHIFT;
+	reuTrace.h.reuSize = reu.reuSize;
+	if ( title )
+	{
+		// only the file name, not the path
+		const char *t = strrchr( title, '/' );
+		strncpy( reuTrace.h.title, t ? t + 1 : title, sizeof( reuTrace.h.title ) - 1 );
+	}
+}
+
+// called when entering the menu: writes the recorded transfers (if any) in one chunk, the decoder unrolls the ring
+void reuTraceFlush( CLogger *logger, const char *DRIVE, u32 armMHz )
+{
+	if ( !reuTraceEnabled || reuTrace.h.magic != REU_TRACE_MAGIC || reuTrace.h.head == 0 )
+		return;
+
+	reuTrace.h.armMHz = armMHz;
+
+	u32 n = reuTrace.h.head < REU_TRACE_ENTRIES ? reuTrace.h.head : REU_TRACE_ENTRIES;
+	writeFile( logger, DRIVE, FILENAME_REU_TRACE, (u8*)&reuTrace, sizeof( REUTRACEHEADER ) + n * sizeof( REUTRACEENTRY ) );
+
+	reuTrace.h.head = 0;
+}
@@ -0,0 +1,94 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - runtime trace of REU transfers (ring buffer, written to SD:RAD/reutrace.bin)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _reu_trace_h
+#define _reu_trace_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// one entry per REU transfer, 16 bytes (two stores when the transfer starts, one when it ends)
+typedef struct
+{
+	u32 time;					// ARM cycle counter / 256 at the start of the transfer
+	u32 addrREU;				// bank << 16 | address
+	u16 addrC64;
+	u16 length;					// as programmed, 0 = 64K
+	u8  command;				// $df01
+	u8  addrCtrl;				// $df0a (fixed addresses)
+	u8  status;					// status bits set by the transfer (end of block, verify error)
+	u8  padding;
+} REUTRACEENTRY;
+
+#define REU_TRACE_ENTRIES		65536		// must be a power of two
+#define REU_TRACE_TIME_SHIFT	8
+
+#define REU_TRACE_MAGIC			0x43525452	// "RTRC"
+#define REU_TRACE_VERSION		1
+
+typedef struct
+{
+	u32 magic, version;
+	u32 nEntries;				// capacity of the ring buffer
+	u32 head;					// total number of transfers recorded, the oldest entry is at head - nEntries (if wrapped)
+	u32 armMHz;
+	u32 reuSize;
+	u32 timeShift;
+	u32 padding;
+	char title[ 224 ];			// image the trace was recorded with (empty if none)
+} REUTRACEHEADER;
+
+typedef struct
+{
+	REUTRACEHEADER h;
+	REUTRACEENTRY e[ REU_TRACE_ENTRIES ];
+} REUTRACE;
+
+extern u32 reuTraceEnabled;
+extern REUTRACE reuTrace;
+
+extern void reuTraceReset( const char *title );
+extern void reuTraceFlush( CLogger *logger, const char *DRIVE, u32 armMHz );
+
+// used by handle_transfer.h
+#define REU_TRACE_BEGIN( T, cycles, r_a, c_a ) 											\
+	if ( reuTraceEnabled ) {															\
+		T = &reuTrace.e[ reuTrace.h.head ++ & ( REU_TRACE_ENTRIES - 1 ) ];				\
+		T->time = (u32)( (cycles) >> REU_TRACE_TIME_SHIFT );							\
+		T->addrREU = (r_a);																\
+		T->addrC64 = (c_a);																\
+		T->length = reu.length;															\
+		T->command = reu.command;														\
+		T->addrCtrl = reu.addrREUCtrl;													\
+		T->status = 0;																	\
+	}
+
+#define REU_TRACE_END( T, newStatus ) 													\
+	if ( reuTraceEnabled ) T->status = (newStatus);
+
+#endif
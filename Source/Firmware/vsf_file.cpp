@@ -0,0 +1,195 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - module directory and partial loading of Vice snapshots (VSF)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <string.h>
+#include "helpers.h"
+#include "rad_hijack.h"
+#include "vsf_file.h"
+
+VSFINDEX vsfIndex;
+
+u32 radVSFVerify = 0;
+VSFRESTORESTATS vsfRestoreStats;
+
+// modules read by doInjectionVSF() and the VSF loading in rad_main.cpp, REU1764 only up to the REU memory
+static const char *vsfModulesNeeded[] = { "MAINCPU", "C64MEM", "C128MEM", "CIA1", "CIA2", "SIDEXTENDED", "VIC-II", "REU1764" };
+#define VSF_SIZE_REU_REGISTERS	20
+
+static u32 vsfNeeded( const char *name )
+{
+	for ( u32 i = 0; i < sizeof( vsfModulesNeeded ) / sizeof( vsfModulesNeeded[ 0 ] ); i++ )
+		if ( strstr( name, vsfModulesNeeded[ i ] ) )
+			return 1;
+	return 0;
+}
+
+static u32 vsfReadAt( FIL *file, u32 ofs, u8 *dst, u32 size )
+{
+	u32 nBytesRead;
+	return f_lseek( file, ofs ) == FR_OK && f_read( file, dst, size, &nBytesRead ) == FR_OK && nBytesRead == size;
+}
+
+int vsfRead( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *buf, u32 bufSize, u32 *size )
+{
+	VSFINDEX *idx = &vsfIndex;
+
+	idx->nModules = 0;
+	*size = 0;
+
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	FIL file;
+	if ( f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", FILENAME );
+		return 0;
+	}
+
+	strncpy( idx->image, FILENAME, 1023 );
+	idx->image[ 1023 ] = 0;
+
+	u32 fileSize = f_size( &file ), ok = 1;
+
+	if ( !vsfReadAt( &file, 0, buf, VSF_SIZE_HEADER ) || memcmp( buf, "VICE Snapshot File", 18 ) )
+	{
+		logger->Write( "RAD", LogNotice, "Not a snapshot: %s", FILENAME );
+		ok = 0;
+	}
+
+	// module directory, one header read per module
+	u8 h[ VSF_SIZE_MODULE_HEADER ];
+	for ( u32 ofs = VSF_SIZE_HEADER; ok && ofs + VSF_SIZE_MODULE_HEADER <= fileSize && idx->nModules < VSF_MODULES_MAX; )
+	{
+		if ( !vsfReadAt( &file, ofs, h, VSF_SIZE_MODULE_HEADER ) )
+			break;
+
+		VSFMODULE *m = &idx->m[ idx->nModules ];
+		memcpy( m->name, h, 16 );
+		m->name[ 16 ] = 0;
+		m->fileOfs = ofs;
+		m->size = (u32)h[ 18 ] | ( (u32)h[ 19 ] << 8 ) | ( (u32)h[ 20 ] << 16 ) | ( (u32)h[ 21 ] << 24 );
+		m->bufOfs = 0;
+
+		if ( m->size < VSF_SIZE_MODULE_HEADER || m->size > fileSize - ofs )
+			break;
+
+		idx->nModules ++;
+		ofs += m->size;
+	}
+
+	// the needed modules, in file order
+	u32 pos = VSF_SIZE_HEADER;
+	for ( u32 i = 0; ok && i < idx->nModules; i++ )
+	{
+		VSFMODULE *m = &idx->m[ i ];
+		if ( !vsfNeeded( m->name ) )
+			continue;
+
+		u32 n = m->size;
+		if ( strstr( m->name, "REU1764" ) && n > VSF_SIZE_MODULE_HEADER + VSF_SIZE_REU_REGISTERS )
+			n = VSF_SIZE_MODULE_HEADER + VSF_SIZE_REU_REGISTERS;
+
+		if ( pos + n > bufSize )
+		{
+			logger->Write( "RAD", LogNotice, "Snapshot module too large: %s", m->name );
+			ok = 0;
+		} else
+		if ( !vsfReadAt( &file, m->fileOfs, &buf[ pos ], n ) )
+		{
+			logger->Write( "RAD", LogError, "Read error" );
+			ok = 0;
+		} else
+		{
+			m->bufOfs = pos;
+			pos += n;
+		}
+	}
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	if ( !ok )
+		idx->nModules = 0;
+
+	*size = pos;
+	return ok;
+}
+
+VSFMODULE *vsfFindModule( const char *name )
+{
+	for ( u32 i = 0; i < vsfIndex.nModules; i++ )
+		if ( vsfIndex.m[ i ].bufOfs && strstr( vsfIndex.m[ i ].name, name ) )
+			return &vsfIndex.m[ i ];
+	return NULL;
+}
+
+int vsfReadREU( CLogger *logger, const char *DRIVE, u8 *mem, u32 size )
+{
+	VSFMODULE *m = vsfFindModule( "REU1764" );
+
+	if ( m == NULL || m->size < VSF_SIZE_MODULE_HEADER + VSF_SIZE_REU_REGISTERS )
+		return 0;
+
+	u32 n = m->size - VSF_SIZE_MODULE_HEADER - VSF_SIZE_REU_REGISTERS;
+	if ( n > size ) n = size;
+
+	if ( fsMount( DRIVE ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot mount drive: %s", DRIVE );
+
+	FIL file;
+	if ( f_open( &file, vsfIndex.image, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		logger->Write( "RAD", LogNotice, "Cannot open file: %s", vsfIndex.image );
+		return 0;
+	}
+
+	u32 ok = vsfReadAt( &file, m->fileOfs + VSF_SIZE_MODULE_HEADER + VSF_SIZE_REU_REGISTERS, mem, n );
+	if ( !ok )
+		logger->Write( "RAD", LogError, "Read error" );
+
+	if ( n < size )
+		memset( &mem[ n ], 0, size - n );
+
+	if ( f_close( &file ) != FR_OK )
+		logger->Write( "RAD", LogPanic, "Cannot close file" );
+
+	return ok;
+}
+
+void vsfRestoreReport( CLogger *logger )
+{
+	VSFRESTORESTATS *s = &vsfRestoreStats;
+	if ( s->pagesMatching + s->pagesWritten == 0 )
+		return;
+
+	logger->Write( "RAD", LogNotice, "VSF restore verified: %d pages matched, %d pages written, %d bytes failed to verify",
+		s->pagesMatching, s->pagesWritten, s->bytesFailed );
+
+	memset( s, 0, sizeof( VSFRESTORESTATS ) );
+}
@@ -0,0 +1,83 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - module directory and partial loading of Vice snapshots (VSF)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _vsf_file_h
+#define _vsf_file_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+// a snapshot is not read as a whole: the module headers are walked once to build a directory (name, position, size),
+// then only the modules needed to restore the C64 are read into a small buffer, which itself is laid out like a VSF 
+// (header followed by the modules); the memory of an REU1764 module is read directly to its destination (vsfReadREU)
+#define VSF_BUFFER_SIZE			( 512 * 1024 )
+#define VSF_SIZE_HEADER			0x3a
+#define VSF_MODULES_MAX			64
+
+typedef struct
+{
+	char name[ 17 ];
+	u32  fileOfs, size;			// position in the file and size including the module header
+	u32  bufOfs;				// position in the buffer, 0 if the module has not been loaded
+} VSFMODULE;
+
+typedef struct
+{
+	u32 nModules;
+	VSFMODULE m[ VSF_MODULES_MAX ];
+	char image[ 1024 ];
+} VSFINDEX;
+
+extern VSFINDEX vsfIndex;
+
+// reads the needed modules of a snapshot to buf (at most bufSize bytes), size is the number of bytes used,
+// returns 0 if the file is not a snapshot or the modules do not fit
+extern int vsfRead( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *buf, u32 bufSize, u32 *size );
+
+// the loaded module whose name contains name (as getVSFModule() always did), or NULL
+extern VSFMODULE *vsfFindModule( const char *name );
+
+// reads the REU memory of the snapshot last read by vsfRead() to mem, size bytes (zero-filled beyond the snapshot data)
+extern int vsfReadREU( CLogger *logger, const char *DRIVE, u8 *mem, u32 size );
+
+// verified restore ("VSF_VERIFY ON" in rad.cfg): the C64's RAM is read back page by page, pages which differ from the
+// snapshot are written and verified; reading costs a bus cycle per byte like writing, i.e. this is never faster than
+// the plain restore (as fast if all pages match, about three times as long if none does)
+typedef struct
+{
+	u32 pagesMatching, pagesWritten;
+	u32 bytesFailed;
+} VSFRESTORESTATS;
+
+extern u32 radVSFVerify;
+extern VSFRESTORESTATS vsfRestoreStats;
+
+// logs the statistics of the verified restores since the last call
+extern void vsfRestoreReport( CLogger *logger );
+
+#endif
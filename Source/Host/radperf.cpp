@@ -0,0 +1,148 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - decoder for the deadline slack histograms (SD:RAD/perf.bin)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <circle/types.h>
+#include "perf_headroom.h"
+
+//
+// radperf - prints the deadline slack histograms written by a RAD built with PERF_HEADROOM
+//
+// usage: radperf [-bins] perf.bin
+//
+// slack is the number of ARM cycles left when arriving at a WAIT_UP_TO_CYCLE_SITE deadline, "late" counts the
+// arrivals after the deadline (the polling loop silently proceeds in this case)
+//
+
+static const char *siteName[ PERF_SITES ] = {
+	"signals", "multiplexer", "write-data", "read2", "trigger-dma", "dma-p1 (addr latch)", "dma-p2 (write hold)", "dma-p3 (read data)"
+};
+
+// smallest slack such that at least 'fraction' of all (timely) arrivals had at most this slack
+static u32 percentile( PERFHEADROOM *p, u32 site, double fraction )
+{
+	u64 n = 0, total = 0;
+	for ( u32 b = 0; b < p->nBins; b++ )
+		total += p->hist[ site ][ b ];
+	if ( total == 0 )
+		return 0;
+	for ( u32 b = 0; b < p->nBins; b++ )
+	{
+		n += p->hist[ site ][ b ];
+		if ( n > 0 && n >= fraction * total )
+			return b << p->binShift;
+	}
+	return ( p->nBins - 1 ) << p->binShift;
+}
+
+int main( int argc, char **argv )
+{
+	const char *fn = NULL;
+	int showBins = 0;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !strcmp( argv[ i ], "-bins" ) ) showBins = 1; else
+			fn = argv[ i ];
+	}
+
+	if ( !fn )
+	{
+		printf( "usage: radperf [-bins] perf.bin\n" );
+		return 1;
+	}
+
+	PERFHEADROOM p;
+	FILE *f = fopen( fn, "rb" );
+	if ( !f || fread( &p, 1, sizeof( PERFHEADROOM ), f ) != sizeof( PERFHEADROOM ) )
+	{
+		printf( "cannot read %s\n", fn );
+		return 1;
+	}
+	fclose( f );
+
+	if ( p.magic != PERF_MAGIC || p.version != PERF_VERSION || p.nSites != PERF_SITES || p.nBins != PERF_BINS )
+	{
+		printf( "%s: not a perf.bin of this version\n", fn );
+		return 1;
+	}
+
+	double nsPerCycle = p.armMHz ? 1000.0 / p.armMHz : 0.0;
+
+	printf( "%s: ARM clock %d MHz, bins of %d cycles\n\n", fn, p.armMHz, 1 << p.binShift );
+	printf( "  %-20s %10s %8s %8s %8s %8s %10s\n", "site", "count", "late", "min", "p1", "p50", "min (ns)" );
+
+	for ( u32 s = 0; s < PERF_SITES; s++ )
+	{
+		if ( p.count[ s ] == 0 )
+		{
+			printf( "  %-20s %10d\n", siteName[ s ], 0 );
+			continue;
+		}
+		printf( "  %-20s %10u %8u %8d %8u %8u %10.1f\n", siteName[ s ], p.count[ s ], p.late[ s ], p.minSlack[ s ],
+			percentile( &p, s, 0.01 ), percentile( &p, s, 0.5 ), p.minSlack[ s ] * nsPerCycle );
+	}
+
+	if ( showBins )
+	{
+		for ( u32 s = 0; s < PERF_SITES; s++ )
+		{
+			if ( p.count[ s ] == 0 )
+				continue;
+
+			u32 maxBin = 1;
+			for ( u32 b = 0; b < p.nBins; b++ )
+				if ( p.hist[ s ][ b ] > maxBin ) maxBin = p.hist[ s ][ b ];
+
+			printf( "\n%s:\n", siteName[ s ] );
+			if ( p.late[ s ] )
+				printf( "  %9s %10u\n", "late", p.late[ s ] );
+			for ( u32 b = 0; b < p.nBins; b++ )
+			{
+				if ( p.hist[ s ][ b ] == 0 )
+					continue;
+				char bar[ 51 ];
+				u32 l = (u32)( 50.0 * p.hist[ s ][ b ] / maxBin + 0.5 );
+				memset( bar, '#', l ); bar[ l ] = 0;
+				char range[ 16 ];
+				if ( b == p.nBins - 1 )
+					snprintf( range, 16, "%d+", b << p.binShift ); else
+					snprintf( range, 16, "%d-%d", b << p.binShift, ( ( b + 1 ) << p.binShift ) - 1 );
+				printf( "  %9s %10u %s\n", range, p.hist[ s ][ b ], bar );
+			}
+		}
+	}
+
+	u64 late = 0;
+	for ( u32 s = 0; s < PERF_SITES; s++ )
+		late += p.late[ s ];
+
+	return late ? 2 : 0;
+}
@@ -0,0 +1,505 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - host-side bus simulator for the REU/GeoRAM polling loops
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "rad_reu.h"
+#include "reu_trace.h"
+#include "reu_prefetch.h"
+#include "reu_pages.h"
+#include "reu_loader.h"
+#include "fingerprint.h"
+#include "sim_bus.h"
+
+//
+// radsim - runs the unmodified REU/GeoRAM polling loops against a simulated C64 bus
+//
+// usage: radsim [-mhz n] [-gpio-read n] [-gpio-write n] [-min-slack n] [-max-cycles n] [-v] [-sd dir] [-trace] [-adaptive] script.sim
+//
+// files the RAD writes when entering the menu go to <dir> (defaults to "."):
+//   -trace enables the REU transfer trace, written to <dir>/RAD/reutrace.bin (see reutrace)
+//   -adaptive uses the adaptive instead of the linear idle preloading (REU_PREFETCH ADAPTIVE)
+//   built with "make PERF=1" the firmware's PERF_HEADROOM instrumentation is compiled in, and the histograms are
+//   written to <dir>/RAD/perf.bin (see radperf)
+//
+// script syntax (one command per line, '#' or ';' start a comment, numbers: 123, $7b or 0x7b):
+//
+//   mode reu|georam            reusize kb | georamsize kb
+//   fresh                      start the REU like without an image: the memory is filled with garbage which the
+//                              firmware has to zero-fill lazily (otherwise it behaves like a loaded all-zero image)
+//   stream n                   the image is read by a simulated loader core, one 64 KB bank every n cycles
+//                              (byte i of bank b is "pattern b" at index i, e.g. "check reu $30000 256 pattern 3")
+//   timing rpi3|default        set <TIMING_NAME> value    mhz n    badlines on|off [yscroll]    pal|ntsc
+//   special flags              reu.isSpecial as set by a title profile (see reu_profile.h)
+//
+//   w addr data                one CPU write cycle
+//   r addr [expect]            one CPU read cycle (optionally checking the value)
+//   idle n                     n CPU cycles without I/O access
+//   stash|fetch|swap|verify c64addr reuaddr length [ctrl] [ff00]
+//                              program REU registers and start a transfer (5 idle cycles before each write)
+//   reset n                    hold /RESET low for n cycles
+//   button                     press the menu button (the polling loop returns)
+//
+//   c64fill|expfill addr length value|pattern seed
+//   check c64|exp addr length value|pattern seed
+//   check irq 0|1
+//
+// zero-time commands (fill/check) are executed when the CPU stream reaches them, i.e. after a preceding
+// transfer has released DMA; the menu button is pressed automatically at the end of the stream
+//
+
+#define REU_MAX_SIZE_KB	(16384)
+u8 mempool[ REU_MAX_SIZE_KB * 1024 + 8192 ] AAA = {0};
+u8 *mempoolPtr = &mempool[ 0 ];
+
+// stand-in for writeFile() from helpers.cpp, "SD:" is mapped to a host directory
+static const char *sdRoot = ".";
+
+int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size )
+{
+	char path[ 1024 ];
+	const char *name = strncmp( FILENAME, DRIVE, strlen( DRIVE ) ) ? FILENAME : FILENAME + strlen( DRIVE );
+
+	// create missing directories along the path
+	snprintf( path, 1024, "%s/%s", sdRoot, name );
+	for ( char *slash = strchr( path + 1, '/' ); slash; slash = strchr( slash + 1, '/' ) )
+	{
+		*slash = 0; mkdir( path, 0755 ); *slash = '/';
+	}
+
+	FILE *f = fopen( path, "wb" );
+	if ( !f )
+	{
+		fprintf( stderr, "cannot write %s\n", path );
+		return 0;
+	}
+	fwrite( data, 1, size, f );
+	fclose( f );
+	printf( "wrote %s (%d bytes)\n", path, size );
+	return 1;
+}
+
+// stand-in for the loader core (reu_loader.cpp), it picks the banks in the same order
+REULOADER reuLoader AAA;
+u32 reuImageFingerprint = 0, reuImageSpecial = 0;
+
+static u32 streamCycles = 0;
+static u64 streamNext = 0;
+
+static void simLoaderCore()
+{
+	if ( !reuLoader.missing || simStats.halfCycles < streamNext )
+		return;
+	streamNext = simStats.halfCycles + 2 * streamCycles;
+
+	u32 b = reuLoader.wanted, next = 0;
+	if ( b >= reuLoader.nBanks || reuBankPresent( b ) )
+	{
+		while ( reuBankPresent( next ) )
+			next ++;
+		b = next;
+	}
+
+	for ( u32 i = 0; i < REU_BANK_SIZE; i++ )
+		mempool[ ( b << REU_BANK_SHIFT ) + i ] = simPattern( b, i );
+
+	reuLoader.present[ b >> 5 ] |= 1 << ( b & 31 );
+	reuLoader.missing --;
+}
+
+extern u8 geoDirty[];
+extern u8 *simGeoRAMInit( u32 sizeKB );
+extern void simGeoRAMRun();
+
+#define MAX_OPS		( 1 << 20 )
+#define MAX_ACTIONS	( 1 << 16 )
+
+static SIMOP ops[ MAX_OPS ];
+static SIMACTION actions[ MAX_ACTIONS ];
+static u32 nOps = 0, nActions = 0;
+
+static u32 modeGeoRAM = 0, expSizeKB = 512, timingMode = AUTO_TIMING_RPI3PLUS_C64C128, freshREU = 0, specialFlags = 0;
+
+static const struct { const char *name; u32 *v; } timings[] = {
+	{ "WAIT_FOR_SIGNALS", &WAIT_FOR_SIGNALS },
+	{ "WAIT_CYCLE_MULTIPLEXER", &WAIT_CYCLE_MULTIPLEXER },
+	{ "WAIT_CYCLE_READ", &WAIT_CYCLE_READ },
+	{ "WAIT_CYCLE_WRITEDATA", &WAIT_CYCLE_WRITEDATA },
+	{ "TIMING_OFFSET_CBTD", &TIMING_OFFSET_CBTD },
+	{ "TIMING_DATA_HOLD", &TIMING_DATA_HOLD },
+	{ "TIMING_TRIGGER_DMA", &TIMING_TRIGGER_DMA },
+	{ "TIMING_ENABLE_ADDRLATCH", &TIMING_ENABLE_ADDRLATCH },
+	{ "TIMING_READ_BA_WRITING", &TIMING_READ_BA_WRITING },
+	{ "TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING", &TIMING_ENABLE_RWOUT_ADDR_LATCH_WRITING },
+	{ "TIMING_ENABLE_DATA_WRITING", &TIMING_ENABLE_DATA_WRITING },
+	{ "TIMING_BA_SIGNAL_AVAIL", &TIMING_BA_SIGNAL_AVAIL },
+	{ "CACHING_L1_WINDOW_KB", &CACHING_L1_WINDOW_KB },
+	{ "CACHING_L2_OFFSET_KB", &CACHING_L2_OFFSET_KB },
+	{ "CACHING_L2_PRELOADS_PER_CYCLE", &CACHING_L2_PRELOADS_PER_CYCLE },
+	{ "TIMING_RW_BEFORE_ADDR", &TIMING_RW_BEFORE_ADDR },
+	{ 0, 0 } };
+
+static struct { const char *name; u32 v; } timingOverride[ 32 ];
+static u32 nTimingOverrides = 0;
+
+static int parseError( u32 line, const char *msg )
+{
+	printf( "script line %d: %s\n", line, msg );
+	exit( 1 );
+}
+
+static u32 number( const char *s, u32 line )
+{
+	char *end;
+	u32 v;
+	if ( !s ) parseError( line, "missing argument" );
+	if ( s[ 0 ] == '$' )
+		v = strtoul( s + 1, &end, 16 ); else
+		v = strtoul( s, &end, 0 );
+	if ( *end ) parseError( line, "invalid number" );
+	return v;
+}
+
+static SIMOP *addOp( u8 type, u32 line )
+{
+	if ( nOps >= MAX_OPS ) parseError( line, "script too long" );
+	SIMOP *o = &ops[ nOps ++ ];
+	memset( o, 0, sizeof( SIMOP ) );
+	o->type = type; o->line = line; o->expect = -1;
+	return o;
+}
+
+static void addWrite( u16 addr, u8 data, u32 line, u32 idleBefore = 0 )
+{
+	if ( idleBefore ) addOp( SIM_OP_IDLE, line )->count = idleBefore;
+	SIMOP *o = addOp( SIM_OP_WRITE, line );
+	o->addr = addr; o->data = data;
+}
+
+static void addAction( u8 type, char **tok, u32 line )
+{
+	if ( nActions >= MAX_ACTIONS ) parseError( line, "too many fill/check commands" );
+	SIMACTION *a = &actions[ nActions ];
+	memset( a, 0, sizeof( SIMACTION ) );
+	a->type = type; a->line = line;
+
+	if ( type == SIM_ACT_CHECK_IRQ )
+	{
+		a->value = number( tok[ 0 ], line );
+	} else
+	{
+		a->addr = number( tok[ 0 ], line );
+		a->length = number( tok[ 1 ], line );
+		if ( tok[ 2 ] && !strcmp( tok[ 2 ], "pattern" ) )
+		{
+			a->isPattern = 1;
+			a->value = number( tok[ 3 ], line );
+		} else
+			a->value = number( tok[ 2 ], line );
+	}
+
+	addOp( SIM_OP_ACTION, line )->count = nActions ++;
+}
+
+static void parseScript( const char *fn )
+{
+	FILE *f = fopen( fn, "r" );
+	if ( !f ) { printf( "cannot open '%s'\n", fn ); exit( 1 ); }
+
+	char buf[ 1024 ];
+	u32 line = 0;
+
+	while ( fgets( buf, sizeof( buf ), f ) )
+	{
+		line ++;
+		char *c = strpbrk( buf, "#;" );
+		if ( c ) *c = 0;
+
+		char *tok[ 16 ] = { 0 };
+		u32 n = 0;
+		for ( char *t = strtok( buf, " \t\r\n" ); t && n < 15; t = strtok( 0, " \t\r\n" ) )
+			tok[ n ++ ] = t;
+		if ( n == 0 ) continue;
+
+		const char *cmd = tok[ 0 ];
+
+		if ( !strcmp( cmd, "mode" ) )
+		{
+			if ( !tok[ 1 ] ) parseError( line, "missing mode" );
+			modeGeoRAM = !strcmp( tok[ 1 ], "georam" );
+		} else
+		if ( !strcmp( cmd, "reusize" ) || !strcmp( cmd, "georamsize" ) )
+			expSizeKB = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "fresh" ) )
+			freshREU = 1; else
+		if ( !strcmp( cmd, "special" ) )
+			specialFlags = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "stream" ) )
+			streamCycles = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "timing" ) )
+			timingMode = tok[ 1 ] && !strcmp( tok[ 1 ], "rpi3" ) ? AUTO_TIMING_RPI3PLUS_C64C128 : 0; else
+		if ( !strcmp( cmd, "set" ) )
+		{
+			if ( !tok[ 1 ] || nTimingOverrides >= 32 ) parseError( line, "invalid set" );
+			timingOverride[ nTimingOverrides ].name = strdup( tok[ 1 ] );
+			timingOverride[ nTimingOverrides ++ ].v = number( tok[ 2 ], line );
+		} else
+		if ( !strcmp( cmd, "mhz" ) )
+			simConfig.armMHz = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "badlines" ) )
+		{
+			simConfig.badlines = tok[ 1 ] && !strcmp( tok[ 1 ], "on" );
+			if ( tok[ 2 ] ) simConfig.yscroll = number( tok[ 2 ], line ) & 7;
+		} else
+		if ( !strcmp( cmd, "pal" ) )
+			simConfig.ntsc = 0; else
+		if ( !strcmp( cmd, "ntsc" ) )
+			simConfig.ntsc = 1; else
+		if ( !strcmp( cmd, "w" ) )
+			addWrite( number( tok[ 1 ], line ), number( tok[ 2 ], line ), line ); else
+		if ( !strcmp( cmd, "r" ) )
+		{
+			SIMOP *o = addOp( SIM_OP_READ, line );
+			o->addr = number( tok[ 1 ], line );
+			if ( tok[ 2 ] ) o->expect = number( tok[ 2 ], line );
+		} else
+		if ( !strcmp( cmd, "idle" ) )
+			addOp( SIM_OP_IDLE, line )->count = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "reset" ) )
+			addOp( SIM_OP_RESET, line )->count = number( tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "button" ) )
+			addOp( SIM_OP_BUTTON, line ); else
+		if ( !strcmp( cmd, "stash" ) || !strcmp( cmd, "fetch" ) || !strcmp( cmd, "swap" ) || !strcmp( cmd, "verify" ) )
+		{
+			u32 type = !strcmp( cmd, "stash" ) ? 0 : !strcmp( cmd, "fetch" ) ? 1 : !strcmp( cmd, "swap" ) ? 2 : 3;
+			u32 c64 = number( tok[ 1 ], line );
+			u32 r = number( tok[ 2 ], line );
+			u32 len = number( tok[ 3 ], line );
+			u32 ctrl = 0, ff00 = 0;
+			for ( u32 i = 4; i < n; i++ )
+				if ( !strcmp( tok[ i ], "ff00" ) ) ff00 = 1; else ctrl = number( tok[ i ], line );
+
+			addWrite( 0xdf02, c64 & 255, line, 5 );
+			addWrite( 0xdf03, c64 >> 8, line, 5 );
+			addWrite( 0xdf04, r & 255, line, 5 );
+			addWrite( 0xdf05, ( r >> 8 ) & 255, line, 5 );
+			addWrite( 0xdf06, ( r >> 16 ) & 255, line, 5 );
+			addWrite( 0xdf07, len & 255, line, 5 );
+			addWrite( 0xdf08, ( len >> 8 ) & 255, line, 5 );
+			addWrite( 0xdf0a, ctrl, line, 5 );
+			if ( ff00 )
+			{
+				addWrite( 0xdf01, REU_COMMAND_EXECUTE | type, line, 5 );
+				addWrite( 0xff00, 0x00, line, 5 );
+			} else
+				addWrite( 0xdf01, REU_COMMAND_EXECUTE | REU_COMMAND_FF00_DISABLED | type, line, 5 );
+			addOp( SIM_OP_IDLE, line )->count = 2;
+		} else
+		if ( !strcmp( cmd, "c64fill" ) )
+			addAction( SIM_ACT_FILL_C64, &tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "expfill" ) || !strcmp( cmd, "reufill" ) )
+			addAction( SIM_ACT_FILL_EXP, &tok[ 1 ], line ); else
+		if ( !strcmp( cmd, "check" ) && tok[ 1 ] )
+		{
+			if ( !strcmp( tok[ 1 ], "c64" ) )
+				addAction( SIM_ACT_CHECK_C64, &tok[ 2 ], line ); else
+			if ( !strcmp( tok[ 1 ], "exp" ) || !strcmp( tok[ 1 ], "reu" ) )
+				addAction( SIM_ACT_CHECK_EXP, &tok[ 2 ], line ); else
+			if ( !strcmp( tok[ 1 ], "irq" ) )
+				addAction( SIM_ACT_CHECK_IRQ, &tok[ 2 ], line ); else
+				parseError( line, "unknown check" );
+		} else
+			parseError( line, "unknown command" );
+	}
+
+	fclose( f );
+}
+
+static void applyTimings()
+{
+	if ( timingMode )
+		setDefaultTimings( timingMode );
+
+	for ( u32 j = 0; j < nTimingOverrides; j++ )
+	{
+		u32 i;
+		for ( i = 0; timings[ i ].name; i++ )
+			if ( !strcmp( timings[ i ].name, timingOverride[ j ].name ) )
+			{
+				*timings[ i ].v = timingOverride[ j ].v;
+				break;
+			}
+		if ( !timings[ i ].name )
+			printf( "warning: unknown timing value '%s'\n", timingOverride[ j ].name );
+	}
+}
+
+static void report( double hostSeconds, s32 minSlackRequired )
+{
+	SIMSTATS *s = &simStats;
+
+	printf( "\nsimulated %llu half-cycles (%.3f ms C64 time) at %d MHz\n", (unsigned long long)s->halfCycles,
+		s->halfCycles / 2 / ( simConfig.ntsc ? 1022.727 : 985.248 ), simConfig.armMHz );
+	printf( "  CPU cycles %llu, halted by DMA %llu, stolen by VIC-II %llu\n",
+		(unsigned long long)s->cpuCycles, (unsigned long long)s->cpuHalted, (unsigned long long)s->vicStolen );
+	printf( "  DMA reads %llu, DMA writes %llu\n", (unsigned long long)s->dmaReads, (unsigned long long)s->dmaWrites );
+	printf( "  GPIO reads %.1f/half-cycle (max %d), writes %.1f/half-cycle (max %d), cycle counter reads %.1f/half-cycle\n",
+		(double)s->gpioReads / s->halfCycles, s->maxGpioReadsPerHalf,
+		(double)s->gpioWrites / s->halfCycles, s->maxGpioWritesPerHalf,
+		(double)s->counterReads / s->halfCycles );
+	printf( "  host time %.1f ns/half-cycle\n", hostSeconds * 1e9 / s->halfCycles );
+	if ( !modeGeoRAM )
+		printf( "  REU pages: %d of %d modified, %d not zero-filled yet\n", reuPagesCount( REU_PAGE_DIRTY ), reuPages.nPages, reuPages.unfilled );
+	if ( modeGeoRAM )
+	{
+		u32 n = 0;
+		for ( u32 i = 0; i < expSizeKB / 16; i++ )
+			n += geoDirty[ i ];
+		printf( "  GeoRAM blocks: %d of %d modified\n", n, expSizeKB / 16 );
+	}
+	if ( streamCycles )
+		printf( "  REU loading: %d of %d banks still missing, transfers waited %d cycles\n", reuLoader.missing, reuLoader.nBanks, reuLoader.stalls );
+	if ( reuPrefetchState.predicted )
+		printf( "  REU preloading (%s): %d of %d transfers started in the preloaded window\n", reuPrefetchState.enabled ? "adaptive" : "linear",
+			reuPrefetchState.hits, reuPrefetchState.predicted );
+
+	printf( "\ndeadline slack (ARM cycles) per WAIT_UP_TO_CYCLE call site:\n" );
+	printf( "  %-28s %10s %8s %8s %8s %8s\n", "site", "count", "min", "avg", "max", "late" );
+
+	s64 minSlack = 1 << 30;
+	for ( u32 i = 0; i < s->nSites; i++ )
+	{
+		SIMSITE *t = &s->site[ i ];
+		const char *fn = strrchr( t->file, '/' ) ? strrchr( t->file, '/' ) + 1 : t->file;
+		char name[ 256 ];
+		snprintf( name, 256, "%s:%d", fn, t->line );
+		printf( "  %-28s %10llu %8lld %8lld %8lld %8llu\n", name, (unsigned long long)t->count,
+			(long long)t->minSlack, (long long)( t->sumSlack / (s64)t->count ), (long long)t->maxSlack, (unsigned long long)t->late );
+		if ( t->minSlack < minSlack ) minSlack = t->minSlack;
+	}
+
+	printf( "\n%llu bus errors, %llu failed checks\n", (unsigned long long)s->errors, (unsigned long long)s->failedChecks );
+
+	if ( minSlack < minSlackRequired )
+	{
+		printf( "timing budget violated: minimum slack %lld < %d\n", (long long)minSlack, minSlackRequired );
+		s->errors ++;
+	}
+}
+
+int main( int argc, char **argv )
+{
+	const char *script = 0;
+	s32 minSlack = -( 1 << 30 );
+	u32 mhz = 0;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !strcmp( argv[ i ], "-mhz" ) && i + 1 < argc )			mhz = atoi( argv[ ++i ] ); else
+		if ( !strcmp( argv[ i ], "-gpio-read" ) && i + 1 < argc )		simConfig.gpioReadCost = atoi( argv[ ++i ] ); else
+		if ( !strcmp( argv[ i ], "-gpio-write" ) && i + 1 < argc )	simConfig.gpioWriteCost = atoi( argv[ ++i ] ); else
+		if ( !strcmp( argv[ i ], "-min-slack" ) && i + 1 < argc )		minSlack = atoi( argv[ ++i ] ); else
+		if ( !strcmp( argv[ i ], "-max-cycles" ) && i + 1 < argc )	simConfig.maxC64Cycles = atoll( argv[ ++i ] ); else
+		if ( !strcmp( argv[ i ], "-v" ) )								simConfig.verbose = 1; else
+		if ( !strcmp( argv[ i ], "-sd" ) && i + 1 < argc )			sdRoot = argv[ ++i ]; else
+		if ( !strcmp( argv[ i ], "-trace" ) )							reuTraceEnabled = 1; else
+		if ( !strcmp( argv[ i ], "-adaptive" ) )						reuPrefetchAdaptive = 1; else
+			script = argv[ i ];
+	}
+
+	if ( !script )
+	{
+		printf( "usage: radsim [-mhz n] [-gpio-read n] [-gpio-write n] [-min-slack n] [-max-cycles n] [-v] [-sd dir] [-trace] [-adaptive] script.sim\n" );
+		return 1;
+	}
+
+	parseScript( script );
+
+	// command line overrides the script
+	if ( mhz )
+		simConfig.armMHz = mhz;
+
+	applyTimings();
+
+	printf( "radsim: %s, %s %dK\n", script, modeGeoRAM ? "GeoRAM" : "REU", expSizeKB );
+
+	simInit( ops, nOps, actions );
+	gpioInit();
+
+	if ( modeGeoRAM )
+	{
+		simExpMemory = simGeoRAMInit( expSizeKB );
+	} else
+	{
+		REU_SIZE_KB = expSizeKB;
+		initREU( mempool );
+		if ( freshREU )
+			memset( mempool, 0xa5, expSizeKB * 1024 ); else
+			reuPagesLoaded( mempool, expSizeKB * 1024, script );
+		if ( streamCycles )
+		{
+			memset( mempool, 0xee, expSizeKB * 1024 );
+			reuLoader.nBanks = expSizeKB >> 6;
+			for ( u32 i = reuLoader.nBanks; i < REU_BANKS_MAX; i++ )
+				reuLoader.present[ i >> 5 ] |= 1 << ( i & 31 );
+			reuLoader.missing = reuLoader.nBanks;
+			streamNext = 2 * streamCycles;
+			simHalfCycleHook = simLoaderCore;
+		}
+		resetREU();
+		reuTraceReset( script );
+		reuPrefetchReset( script );
+		reu.isSpecial = specialFlags;
+		simExpMemory = mempool;
+	}
+	simExpSize = expSizeKB * 1024;
+
+	simStart();
+	clock_t t0 = clock();
+
+	if ( modeGeoRAM )
+		simGeoRAMRun(); else
+		reuUsingPolling( 2 );
+
+	clock_t t1 = clock();
+
+	simRunRemainingActions();
+
+	report( (double)( t1 - t0 ) / CLOCKS_PER_SEC, minSlack );
+
+	CLogger logger;
+	reuTraceFlush( &logger, "SD:", simConfig.armMHz );
+#ifdef PERF_HEADROOM
+	perfHeadroomDump( &logger, "SD:", simConfig.armMHz );
+#endif
+
+	return ( simStats.errors || simStats.failedChecks ) ? 1 : 0;
+}
@@ -0,0 +1,517 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - Cortex-A53 L1/L2 model replaying REU traces to compare prefetch policies
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <circle/types.h>
+#include "trace_file.h"
+#include "reu_prefetch.h"
+
+//
+// reucache - replays REU transfer traces (SD:RAD/reutrace.bin) through a model of the Cortex-A53 data caches
+// and reports the predicted misses of the REU memory accesses for different cache preloading policies
+//
+// usage: reucache [options] reutrace.bin [more traces ...]
+//
+//   -l1 kb ways          L1 data cache (default 32K, 4-way)
+//   -l2 kb ways          L2 cache (default 512K, 16-way)
+//   -lat-l2 n            L2 hit latency in ARM cycles (default 15)
+//   -lat-mem n           DRAM latency in ARM cycles (default 180)
+//   -fills n             max. outstanding DRAM line fills, further prefetches are dropped (default 0 = unlimited)
+//   -mhz n               ARM clock if not stored in the trace (default 1400)
+//   -demand n            ARM cycles from the start of a DMA cycle to the REU memory access (default 100)
+//   -budget n            stalls longer than this are reported as critical (default 60)
+//   -l1window kb         CACHING_L1_WINDOW_KB (default 4)
+//   -l2offset kb         CACHING_L2_OFFSET_KB (default 0)
+//   -l2per n             CACHING_L2_PRELOADS_PER_CYCLE (default 2)
+//   -setup n             C64 cycles between writing the REU registers and starting a transfer (default 40)
+//   -max-idle n          idle C64 cycles simulated between two transfers (default 512)
+//   -sweep               additionally sweep CACHING_L1_WINDOW_KB x CACHING_L2_OFFSET_KB for the firmware policy
+//
+// the model replicates what reuUsingPolling()/handle_transfer.h do: PRFM PLDL1STRM/PSTL1STRM (CACHE_PRELOADL1STRM(W))
+// within the transfer loops, and the round-robin PLDL2KEEP (reu.pl) and PLDL1STRM (reu.pl2) preloading in idle cycles
+// of the window given by the REU registers (linear) or predicted by reu_prefetch.h after a transfer (adaptive);
+// STRM lines are inserted as least recently used, KEEP lines as most recently used. Both caches use LRU replacement,
+// L1 fills also allocate in L2. Code, stack and other data accesses are not modeled
+//
+
+#define LINE_SHIFT	6
+
+struct CACHELEVEL
+{
+	u32 nSets, nWays;
+	std::vector<u64> tag;			// line + 1, 0 = invalid
+	std::vector<u64> stamp;			// LRU
+	std::vector<u64> ready;			// time when the line fill completes
+	u64 clock;
+
+	void init( u32 sizeKB, u32 ways )
+	{
+		nWays = ways;
+		nSets = ( sizeKB * 1024 >> LINE_SHIFT ) / ways;
+		tag.assign( nSets * nWays, 0 );
+		stamp.assign( nSets * nWays, 0 );
+		ready.assign( nSets * nWays, 0 );
+		clock = 0;
+	}
+
+	int find( u64 line )
+	{
+		u32 s = ( line % nSets ) * nWays;
+		for ( u32 w = 0; w < nWays; w++ )
+			if ( tag[ s + w ] == line + 1 )
+				return s + w;
+		return -1;
+	}
+
+	void touch( int i ) { stamp[ i ] = ++clock; }
+
+	int insert( u64 line, u64 readyTime, bool streaming )
+	{
+		u32 s = ( line % nSets ) * nWays, v = s;
+		for ( u32 w = 0; w < nWays; w++ )
+		{
+			if ( tag[ s + w ] == 0 ) { v = s + w; break; }
+			if ( stamp[ s + w ] < stamp[ v ] ) v = s + w;
+		}
+		tag[ v ] = line + 1;
+		stamp[ v ] = streaming ? 0 : ++clock;
+		ready[ v ] = readyTime;
+		return v;
+	}
+};
+
+struct CONFIG
+{
+	u32 l1KB = 32, l1Ways = 4, l2KB = 512, l2Ways = 16;
+	u32 latL2 = 15, latMem = 180, maxFills = 0;
+	u32 mhz = 1400, demandOffset = 100, budget = 60;
+	u32 l1WindowKB = 4, l2OffsetKB = 0, l2PerCycle = 2;
+	u32 setupCycles = 40, maxIdle = 512;
+} cfg;
+
+struct POLICY
+{
+	const char *name;
+	u32 inLoop;						// prefetches in the transfer loops
+	u32 distance;					// ... this many lines ahead (firmware: 1)
+	u32 idleL2, idleL1;				// round-robin preloading in idle cycles
+	u32 adaptive;					// idle preloading of the predicted window after a transfer (REU_PREFETCH ADAPTIVE)
+};
+
+static const POLICY policies[] = {
+	{ "none",			0, 0, 0, 0, 0 },
+	{ "loop only",		1, 1, 0, 0, 0 },
+	{ "idle only",		0, 0, 1, 1, 0 },
+	{ "idle L2 only",	0, 0, 1, 0, 0 },
+	{ "linear",			1, 1, 1, 1, 0 },
+	{ "linear d=2",		1, 2, 1, 1, 0 },
+	{ "linear d=4",		1, 4, 1, 1, 0 },
+	{ "adaptive",		1, 1, 1, 1, 1 },
+	{ "adaptive d=2",	1, 2, 1, 1, 1 },
+};
+
+struct STATS
+{
+	u64 demand, l1Hit, l1Late, l2Hit, mem;
+	u64 stallSum, stallMax, critical;
+	u64 prefetches, useless, dropped;
+	u64 predicted, predictionHits;
+};
+
+struct MODEL
+{
+	CACHELEVEL l1, l2;
+	std::vector<u64> fills;
+	STATS s;
+
+	void init()
+	{
+		l1.init( cfg.l1KB, cfg.l1Ways );
+		l2.init( cfg.l2KB, cfg.l2Ways );
+		fills.clear();
+		memset( &s, 0, sizeof( s ) );
+	}
+
+	// returns 0 if another DRAM fill cannot be started at time t
+	bool startFill( u64 t )
+	{
+		if ( !cfg.maxFills )
+			return true;
+		u32 n = 0;
+		for ( u32 i = 0; i < fills.size(); )
+			if ( fills[ i ] <= t ) { fills[ i ] = fills.back(); fills.pop_back(); } else { n ++; i ++; }
+		if ( n >= cfg.maxFills )
+			return false;
+		fills.push_back( t + cfg.latMem );
+		return true;
+	}
+
+	// demand load/store, returns the stall in ARM cycles
+	u64 access( u64 addr, u64 t, bool count = true )
+	{
+		u64 line = addr >> LINE_SHIFT, stall;
+		int i = l1.find( line );
+
+		if ( i >= 0 )
+		{
+			l1.touch( i );
+			stall = l1.ready[ i ] > t ? l1.ready[ i ] - t : 0;
+			if ( count ) { if ( stall ) s.l1Late ++; else s.l1Hit ++; }
+		} else
+		{
+			int j = l2.find( line );
+			if ( j >= 0 )
+			{
+				l2.touch( j );
+				stall = ( l2.ready[ j ] > t ? l2.ready[ j ] - t : 0 ) + cfg.latL2;
+				if ( count ) s.l2Hit ++;
+			} else
+			{
+				// a demand miss waits for a free fill slot
+				while ( !startFill( t ) ) t ++;
+				stall = cfg.latMem;
+				l2.insert( line, t + stall, false );
+				if ( count ) s.mem ++;
+			}
+			l1.insert( line, t + stall, false );
+		}
+
+		if ( count )
+		{
+			s.demand ++;
+			s.stallSum += stall;
+			if ( stall > s.stallMax ) s.stallMax = stall;
+			if ( stall > cfg.budget ) s.critical ++;
+		}
+		return stall;
+	}
+
+	// PRFM: level 1 = PLDL1/PSTL1, level 2 = PLDL2
+	void prefetch( u64 addr, u64 t, int level, bool streaming )
+	{
+		u64 line = addr >> LINE_SHIFT;
+		s.prefetches ++;
+
+		int i = l1.find( line );
+		if ( i >= 0 )
+		{
+			s.useless ++;
+			return;
+		}
+
+		int j = l2.find( line );
+		if ( level == 2 )
+		{
+			if ( j >= 0 )
+			{
+				if ( !streaming ) l2.touch( j );
+				s.useless ++;
+				return;
+			}
+			if ( !startFill( t ) ) { s.dropped ++; return; }
+			l2.insert( line, t + cfg.latMem, streaming );
+			return;
+		}
+
+		u64 readyTime;
+		if ( j >= 0 )
+		{
+			readyTime = ( l2.ready[ j ] > t ? l2.ready[ j ] : t ) + cfg.latL2;
+		} else
+		{
+			if ( !startFill( t ) ) { s.dropped ++; return; }
+			readyTime = t + cfg.latMem;
+			l2.insert( line, readyTime, false );
+		}
+		l1.insert( line, readyTime, streaming );
+	}
+};
+
+// what the firmware does by default (REU_PREFETCH ADAPTIVE)
+#define FIRMWARE_POLICY	7
+
+// state of the REU registers as seen by the idle preloading
+struct REUREGS
+{
+	u32 addr;						// bank << 16 | address
+	u16 length, pl, pl2;
+};
+
+static void replay( MODEL &m, const POLICY &p, const REUTRACEHEADER &h, const std::vector<REUTRACEENTRY> &trace )
+{
+	u32 mhz = h.armMHz ? h.armMHz : cfg.mhz;
+	double cyc = mhz * 1e6 / 985248.0;			// ARM cycles per C64 cycle
+	u32 wrapMask = reuWrapMask( h.reuSize );
+	u32 wrapAround = h.reuSize == 0x20000 ? 0x20000 : 0x80000;
+	u16 l1Window = cfg.l1WindowKB * 1024, l2Offset = cfg.l2OffsetKB * 1024;
+	u64 mem = 1ull << 32;						// base address of the (simulated) REU memory
+
+	REUREGS r = { 0, 0xffff, l2Offset, 0 };
+	u64 t = 0, time = 0;
+	u32 lastStamp = trace.size() ? trace[ 0 ].time : 0;
+
+	for ( const REUTRACEENTRY &e : trace )
+	{
+		time += (u32)( e.time - lastStamp );
+		lastStamp = e.time;
+		u64 tStart = time << h.timeShift;
+		if ( tStart < t ) tStart = t;
+
+		// idle cycles (polling loop) until the transfer starts, the REU registers are written shortly before
+		u64 nIdle = (u64)( ( tStart - t ) / cyc );
+		u64 k = nIdle > cfg.maxIdle ? nIdle - cfg.maxIdle : 0;
+		bool setup = false;
+		for ( ; k < nIdle; k++ )
+		{
+			u64 tc = tStart - (u64)( ( nIdle - k ) * cyc );
+
+			if ( !setup && nIdle - k <= cfg.setupCycles )
+			{
+				r.addr = e.addrREU; r.length = e.length; r.pl = l2Offset; r.pl2 = 0;
+				m.prefetch( mem + ( r.addr & wrapMask ), tc, 2, false );
+				setup = true;
+			}
+
+			if ( p.idleL2 )
+				for ( u32 i = 0; i < cfg.l2PerCycle; i++ )
+				{
+					m.prefetch( mem + ( ( ( r.addr + r.pl ) & ~63 ) & wrapMask ), tc, 2, false );
+					r.pl += 64;
+					if ( r.pl >= r.length + 64 ) r.pl = 0;
+				}
+
+			if ( p.idleL1 )
+			{
+				m.prefetch( mem + ( ( ( r.addr + r.pl2 ) & ~63 ) & ( h.reuSize - 1 ) ), tc, 1, true );
+				r.pl2 += 64;
+				if ( r.pl2 >= ( ( l1Window - 64 ) < r.length ? l1Window - 64 : r.length ) ) r.pl2 = 0;
+			}
+
+			// forceRead = reuLoad32( 0 )
+			m.access( mem, tc, false );
+		}
+
+		if ( !setup )
+		{
+			r.addr = e.addrREU; r.length = e.length; r.pl = l2Offset; r.pl2 = 0;
+			m.prefetch( mem + ( r.addr & wrapMask ), tStart, 2, false );
+		}
+
+		// the transfer itself, one byte per C64 cycle (swap: two)
+		u32 cmd = e.command & 3;
+		u32 len = e.length ? e.length : 0x10000;
+		u32 fixREU = e.addrCtrl & 0x40;
+		u32 a = e.addrREU & 0xffffff, prev = a;
+		u32 d = 64 * p.distance;
+
+		#define LOC( x ) ( mem + ( (x) & wrapMask ) )
+		#define IN_RANGE( x ) ( ( (x) & wrapMask ) < h.reuSize )
+
+		if ( p.inLoop )
+		{
+			m.prefetch( LOC( a ), tStart, 1, true );
+			m.prefetch( LOC( a ), tStart, 1, true );
+		}
+
+		for ( u32 i = 0; i < len; i++ )
+		{
+			u64 tc = tStart + (u64)( i * cyc * ( cmd == 2 ? 2 : 1 ) );
+			u64 td = tc + cfg.demandOffset;
+			u32 next = a;
+			if ( !fixREU )
+			{
+				u32 n = ( a & 0x7ffff ) + 1;
+				if ( n == wrapAround ) n = 0;
+				next = ( a & 0xf80000 ) | n;
+			}
+
+			switch ( cmd )
+			{
+			case 0: // stash
+				if ( p.inLoop ) m.prefetch( LOC( a ), tc, 1, true );
+				if ( i > 0 && IN_RANGE( prev ) ) m.access( LOC( prev ), td );
+				if ( p.inLoop ) m.prefetch( LOC( next + d ), td, 1, true );
+				break;
+			case 1: // fetch
+				if ( p.inLoop ) m.prefetch( LOC( next ), tc, 1, true );
+				if ( IN_RANGE( a ) ) m.access( LOC( a ), td );
+				if ( p.inLoop ) { m.prefetch( LOC( next ), td, 1, true ); m.prefetch( LOC( next + d ), td, 1, true ); }
+				break;
+			case 2: // swap
+				if ( p.inLoop ) { m.prefetch( LOC( a ), tc, 1, true ); m.prefetch( LOC( next ), tc, 1, true ); m.prefetch( LOC( a + d ), tc, 1, true ); }
+				if ( IN_RANGE( a ) ) { m.access( LOC( a ), td ); m.access( LOC( a ), td + (u64)cyc ); }
+				break;
+			case 3: // verify
+				if ( p.inLoop ) { m.prefetch( LOC( a ), tc, 1, true ); m.prefetch( LOC( a + d ), tc, 1, true ); }
+				if ( IN_RANGE( a ) ) m.access( LOC( a ), td );
+				break;
+			}
+			prev = a;
+			a = next;
+		}
+		if ( cmd == 0 && IN_RANGE( prev ) )
+			m.access( LOC( prev ), tStart + (u64)( len * cyc ) );
+
+		#undef LOC
+		#undef IN_RANGE
+
+		t = tStart + (u64)( len * cyc * ( cmd == 2 ? 2 : 1 ) );
+
+		// reuUpdateRegisters(), reuPrefetchAfterTransfer()
+		reuPrefetchLearn( e.addrREU & 0xffffff, fixREU ? 1 : len );
+		if ( p.adaptive )
+		{
+			r.addr = reuPrefetchState.predBase;
+			r.length = reuPrefetchState.predLength > 0xffff ? 0xffff : reuPrefetchState.predLength;
+			r.pl = l2Offset; r.pl2 = 0;
+		} else
+		if ( e.command & 0x20 )
+		{
+			r.addr = e.addrREU; r.length = e.length;
+		} else
+		{
+			if ( !fixREU ) r.addr = a;
+			r.length = 1;
+		}
+	}
+}
+
+static void run( const POLICY &p, std::vector<REUTRACEHEADER> &h, std::vector< std::vector<REUTRACEENTRY> > &traces, STATS &s )
+{
+	MODEL m;
+	memset( &s, 0, sizeof( s ) );
+	for ( u32 i = 0; i < traces.size(); i++ )
+	{
+		m.init();
+		reuPrefetchReset( NULL );
+		replay( m, p, h[ i ], traces[ i ] );
+		s.predicted += reuPrefetchState.predicted; s.predictionHits += reuPrefetchState.hits;
+		s.demand += m.s.demand; s.l1Hit += m.s.l1Hit; s.l1Late += m.s.l1Late; s.l2Hit += m.s.l2Hit; s.mem += m.s.mem;
+		s.stallSum += m.s.stallSum; s.critical += m.s.critical;
+		if ( m.s.stallMax > s.stallMax ) s.stallMax = m.s.stallMax;
+		s.prefetches += m.s.prefetches; s.useless += m.s.useless; s.dropped += m.s.dropped;
+	}
+}
+
+int main( int argc, char **argv )
+{
+	std::vector<REUTRACEHEADER> headers;
+	std::vector< std::vector<REUTRACEENTRY> > traces;
+	int sweep = 0;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		#define ARG( name, v ) if ( !strcmp( argv[ i ], name ) && i + 1 < argc ) { v = atoi( argv[ ++i ] ); continue; }
+		#define ARG2( name, v1, v2 ) if ( !strcmp( argv[ i ], name ) && i + 2 < argc ) { v1 = atoi( argv[ ++i ] ); v2 = atoi( argv[ ++i ] ); continue; }
+		ARG2( "-l1", cfg.l1KB, cfg.l1Ways )
+		ARG2( "-l2", cfg.l2KB, cfg.l2Ways )
+		ARG( "-lat-l2", cfg.latL2 )
+		ARG( "-lat-mem", cfg.latMem )
+		ARG( "-fills", cfg.maxFills )
+		ARG( "-mhz", cfg.mhz )
+		ARG( "-demand", cfg.demandOffset )
+		ARG( "-budget", cfg.budget )
+		ARG( "-l1window", cfg.l1WindowKB )
+		ARG( "-l2offset", cfg.l2OffsetKB )
+		ARG( "-l2per", cfg.l2PerCycle )
+		ARG( "-setup", cfg.setupCycles )
+		ARG( "-max-idle", cfg.maxIdle )
+		#undef ARG
+		#undef ARG2
+		if ( !strcmp( argv[ i ], "-sweep" ) ) { sweep = 1; continue; }
+
+		REUTRACEHEADER h;
+		std::vector<REUTRACEENTRY> e;
+		if ( !readREUTrace( argv[ i ], h, e ) )
+			return 1;
+		headers.push_back( h );
+		traces.push_back( e );
+	}
+
+	if ( traces.empty() )
+	{
+		printf( "usage: reucache [-l1 kb ways] [-l2 kb ways] [-lat-l2 n] [-lat-mem n] [-fills n] [-mhz n] [-demand n] [-budget n]\n"
+				"                [-l1window kb] [-l2offset kb] [-l2per n] [-setup n] [-max-idle n] [-sweep] reutrace.bin ...\n" );
+		return 1;
+	}
+
+	printf( "L1 %dK %d-way, L2 %dK %d-way, latency L2 %d / DRAM %d cycles, CACHING_L1_WINDOW_KB %d, CACHING_L2_OFFSET_KB %d, CACHING_L2_PRELOADS_PER_CYCLE %d\n\n",
+		cfg.l1KB, cfg.l1Ways, cfg.l2KB, cfg.l2Ways, cfg.latL2, cfg.latMem, cfg.l1WindowKB, cfg.l2OffsetKB, cfg.l2PerCycle );
+
+	printf( "  %-14s %10s %7s %7s %7s %7s %9s %6s %9s %10s %8s %8s\n", "policy", "accesses", "L1 %", "late %", "L2 %", "DRAM %",
+		"avg stall", "max", "critical", "prefetches", "useless", "dropped" );
+
+	STATS predictionStats = {};
+	for ( const POLICY &p : policies )
+	{
+		STATS s;
+		run( p, headers, traces, s );
+		double n = s.demand ? (double)s.demand : 1.0;
+		printf( "  %-14s %10llu %7.2f %7.2f %7.2f %7.2f %9.2f %6llu %9llu %10llu %7.1f%% %7.1f%%\n", p.name, (unsigned long long)s.demand,
+			100.0 * s.l1Hit / n, 100.0 * s.l1Late / n, 100.0 * s.l2Hit / n, 100.0 * s.mem / n, s.stallSum / n,
+			(unsigned long long)s.stallMax, (unsigned long long)s.critical, (unsigned long long)s.prefetches,
+			s.prefetches ? 100.0 * s.useless / s.prefetches : 0.0, s.prefetches ? 100.0 * s.dropped / s.prefetches : 0.0 );
+
+		if ( &p == &policies[ FIRMWARE_POLICY ] )
+			predictionStats = s;
+	}
+
+	printf( "\nadaptive preloading: next transfer window predicted for %llu of %llu transfers (%.1f%%)\n",
+		(unsigned long long)predictionStats.predictionHits, (unsigned long long)predictionStats.predicted,
+		predictionStats.predicted ? 100.0 * predictionStats.predictionHits / predictionStats.predicted : 0.0 );
+
+	if ( sweep )
+	{
+		static const u32 windows[] = { 1, 2, 4, 8, 16, 32 };
+		static const u32 offsets[] = { 0, 1, 2, 4, 8, 16, 32 };
+
+		printf( "\ncritical stalls (> %d cycles) of the firmware policy, CACHING_L1_WINDOW_KB (rows) x CACHING_L2_OFFSET_KB (columns):\n\n      ", cfg.budget );
+		for ( u32 o : offsets ) printf( " %9d", o );
+		printf( "\n" );
+
+		u32 saveWindow = cfg.l1WindowKB, saveOffset = cfg.l2OffsetKB;
+		for ( u32 w : windows )
+		{
+			printf( "  %3d ", w );
+			for ( u32 o : offsets )
+			{
+				STATS s;
+				cfg.l1WindowKB = w; cfg.l2OffsetKB = o;
+				run( policies[ FIRMWARE_POLICY ], headers, traces, s );
+				printf( " %9llu", (unsigned long long)s.critical );
+			}
+			printf( "\n" );
+		}
+		cfg.l1WindowKB = saveWindow; cfg.l2OffsetKB = saveOffset;
+	}
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - decoder for REU transfer traces (SD:RAD/reutrace.bin)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <circle/types.h>
+#include "trace_file.h"
+
+//
+// reutrace - access statistics of REU transfer traces recorded by the RAD (REU_TRACE ON in rad.cfg)
+//
+// usage: reutrace [-list] reutrace.bin [more traces ...]
+//
+// traces are grouped by the title (image) they were recorded with; for each title it prints the command mix,
+// the distribution of transfer lengths, the distance between consecutive transfers and how the accessed bytes
+// spread over the 64K banks -- which is what CACHING_L1_WINDOW_KB and CACHING_L2_OFFSET_KB should be tuned to
+//
+
+static const char *cmdName[ 4 ] = { "stash", "fetch", "swap", "verify" };
+
+struct STATS
+{
+	u32 armMHz = 0, reuSize = 0;
+	u64 transfers = 0, bytes = 0, fixedREU = 0, fixedC64 = 0, verifyErrors = 0;
+	u64 perCmd[ 4 ] = {}, bytesPerCmd[ 4 ] = {};
+	u64 lengthLog2[ 18 ] = {};
+	u64 sequential = 0, sameStart = 0, distLog2[ 26 ] = {};
+	std::map<s32, u64> stride;
+	std::map<u32, u64> bankBytes;
+	u64 firstTime = 0, lastTime = 0, time = 0;
+	u32 prevStart = 0, prevEnd = 0, hasPrev = 0;
+};
+
+static u32 log2i( u64 v )
+{
+	u32 r = 0;
+	while ( v >>= 1 ) r ++;
+	return r;
+}
+
+static void addEntry( STATS &s, REUTRACEENTRY *e, u32 timeShift, u32 wrapMask )
+{
+	u32 len = e->length ? e->length : 0x10000;
+	u32 cmd = e->command & 3;
+	u32 fixREU = e->addrCtrl & 0x40, fixC64 = e->addrCtrl & 0x80;
+	u32 start = e->addrREU & 0xffffff;
+
+	// 32-bit time stamps wrap around, consecutive deltas don't
+	if ( s.transfers == 0 )
+		s.time = s.firstTime = e->time; else
+		s.time += (u32)( e->time - (u32)s.lastTime );
+	s.lastTime = e->time;
+
+	s.transfers ++;
+	s.bytes += len;
+	s.perCmd[ cmd ] ++;
+	s.bytesPerCmd[ cmd ] += len;
+	s.lengthLog2[ log2i( len ) ] ++;
+	if ( fixREU ) s.fixedREU ++;
+	if ( fixC64 ) s.fixedC64 ++;
+	if ( e->status & 0x20 ) s.verifyErrors ++;
+
+	if ( s.hasPrev )
+	{
+		s32 d = (s32)start - (s32)s.prevStart;
+		if ( start == s.prevEnd ) s.sequential ++;
+		if ( d == 0 ) s.sameStart ++;
+		s.stride[ d ] ++;
+		s.distLog2[ d == 0 ? 0 : log2i( (u32)abs( d ) ) + 1 ] ++;
+	}
+	s.hasPrev = 1;
+	s.prevStart = start;
+	s.prevEnd = fixREU ? start : ( ( start + len ) & wrapMask );
+
+	// bytes per 64K bank (fixed REU address: all bytes in one place)
+	if ( fixREU )
+		s.bankBytes[ start >> 16 ] += len; else
+	{
+		u32 a = start, l = len;
+		while ( l )
+		{
+			u32 n = std::min( l, 0x10000 - ( a & 0xffff ) );
+			s.bankBytes[ ( a & wrapMask ) >> 16 ] += n;
+			a += n; l -= n;
+		}
+	}
+}
+
+static void printStats( const std::string &title, STATS &s )
+{
+	printf( "\n=== %s ===\n", title.empty() ? "(no image)" : title.c_str() );
+	printf( "%llu transfers, %llu bytes (%.1f bytes/transfer), REU %dK\n", (unsigned long long)s.transfers,
+		(unsigned long long)s.bytes, (double)s.bytes / s.transfers, s.reuSize / 1024 );
+
+	if ( s.armMHz && s.transfers > 1 )
+	{
+		double us = (double)( s.time - s.firstTime ) * 256.0 / s.armMHz;
+		printf( "recorded %.2f s, %.0f transfers/s, %.1f us between transfers on average\n", us / 1e6,
+			( s.transfers - 1 ) / us * 1e6, us / ( s.transfers - 1 ) );
+	}
+
+	printf( "\ncommands:\n" );
+	for ( u32 c = 0; c < 4; c++ )
+		if ( s.perCmd[ c ] )
+			printf( "  %-8s %10llu transfers %12llu bytes\n", cmdName[ c ], (unsigned long long)s.perCmd[ c ], (unsigned long long)s.bytesPerCmd[ c ] );
+	printf( "  fixed REU address %llu, fixed C64 address %llu, verify errors %llu\n", (unsigned long long)s.fixedREU,
+		(unsigned long long)s.fixedC64, (unsigned long long)s.verifyErrors );
+
+	printf( "\ntransfer length (bytes):   transfers   cumulative\n" );
+	u64 cum = 0;
+	for ( u32 b = 0; b < 18; b++ )
+	{
+		if ( !s.lengthLog2[ b ] ) continue;
+		cum += s.lengthLog2[ b ];
+		char range[ 32 ];
+		if ( b == 0 ) sprintf( range, "1" ); else
+		if ( b == 16 ) sprintf( range, "64K" ); else
+			sprintf( range, "%d-%d", 1 << b, ( 2 << b ) - 1 );
+		printf( "  %-20s %12llu %11.1f%%\n", range, (unsigned long long)s.lengthLog2[ b ], 100.0 * cum / s.transfers );
+	}
+
+	if ( s.transfers > 1 )
+	{
+		u64 n = s.transfers - 1;
+		printf( "\nconsecutive transfers: %.1f%% continue where the previous one ended, %.1f%% start at the same address\n",
+			100.0 * s.sequential / n, 100.0 * s.sameStart / n );
+
+		printf( "distance between start addresses:\n" );
+		for ( u32 b = 0; b < 26; b++ )
+		{
+			if ( !s.distLog2[ b ] ) continue;
+			char range[ 32 ];
+			u32 lo = b ? 1 << ( b - 1 ) : 0;
+			if ( b == 0 ) sprintf( range, "0" ); else
+			if ( lo >= 1024 ) sprintf( range, "%dK-%dK", lo / 1024, lo * 2 / 1024 ); else
+				sprintf( range, "%d-%d", lo, lo * 2 - 1 );
+			printf( "  %-20s %12llu %11.1f%%\n", range, (unsigned long long)s.distLog2[ b ], 100.0 * s.distLog2[ b ] / n );
+		}
+
+		std::vector< std::pair<u64, s32> > top;
+		for ( auto &i : s.stride ) top.push_back( std::make_pair( i.second, i.first ) );
+		std::sort( top.rbegin(), top.rend() );
+		printf( "most frequent strides:\n" );
+		for ( u32 i = 0; i < top.size() && i < 8; i++ )
+			printf( "  %+10d (%s$%06x) %12llu %11.1f%%\n", top[ i ].second, top[ i ].second < 0 ? "-" : "+",
+				abs( top[ i ].second ), (unsigned long long)top[ i ].first, 100.0 * top[ i ].first / n );
+	}
+
+	std::vector< std::pair<u64, u32> > banks;
+	for ( auto &i : s.bankBytes ) banks.push_back( std::make_pair( i.second, i.first ) );
+	std::sort( banks.rbegin(), banks.rend() );
+	printf( "\nbank hotness (%d banks touched):\n", (int)banks.size() );
+	cum = 0;
+	for ( u32 i = 0; i < banks.size() && i < 16; i++ )
+	{
+		cum += banks[ i ].first;
+		printf( "  bank $%02x %16llu bytes %6.1f%%  (cumulative %5.1f%%)\n", banks[ i ].second, (unsigned long long)banks[ i ].first,
+			100.0 * banks[ i ].first / s.bytes, 100.0 * cum / s.bytes );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	int list = 0, nFiles = 0;
+	std::map<std::string, STATS> titles;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !strcmp( argv[ i ], "-list" ) ) { list = 1; continue; }
+
+		REUTRACEHEADER h;
+		std::vector<REUTRACEENTRY> e;
+		if ( !readREUTrace( argv[ i ], h, e ) )
+			return 1;
+		nFiles ++;
+
+		STATS &s = titles[ h.title ];
+		s.armMHz = h.armMHz;
+		s.reuSize = h.reuSize;
+
+		u32 wrapMask = reuWrapMask( h.reuSize );
+
+		for ( u32 j = 0; j < e.size(); j++ )
+		{
+			REUTRACEENTRY *t = &e[ j ];
+			if ( list )
+				printf( "%10u %-6s c64 $%04x reu $%06x len %5d ctrl $%02x status $%02x\n", t->time, cmdName[ t->command & 3 ],
+					t->addrC64, t->addrREU, t->length ? t->length : 0x10000, t->addrCtrl, t->status );
+			addEntry( s, t, h.timeShift, wrapMask );
+		}
+	}
+
+	if ( !nFiles )
+	{
+		printf( "usage: reutrace [-list] reutrace.bin [more traces ...]\n" );
+		return 1;
+	}
+
+	for ( auto &t : titles )
+		if ( t.second.transfers )
+			printStats( t.first, t.second );
+
+	return 0;
+}
@@ -0,0 +1,228 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - converter between plain and compressed REU/GeoRAM images
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <circle/types.h>
+#include "lz_image.h"
+#include "crc32.h"
+
+//
+// reuz - converts REU/GeoRAM images to the compressed format the RAD loads (.reuz/.georamz) and back
+//
+// usage: reuz image.reu image.reuz       compress
+//        reuz -d image.reuz image.reu    decompress
+//        reuz -fingerprint image         CRC-32 of the (decompressed) image, as the RAD identifies titles
+//        reuz -selftest                  round trip of synthetic images and CRC-32 check (part of "make test")
+//
+// the format is described in ../Firmware/lz_image.h; the RAD writes the same files when saving a mounted
+// compressed image or with IMAGE_COMPRESSION ON in rad.cfg
+//
+
+static std::vector<u8> compressImage( const std::vector<u8> &img )
+{
+	LZIMAGEHEADER h;
+	h.magic = LZIMAGE_MAGIC;
+	h.size = img.size();
+	h.blockShift = LZIMAGE_BLOCK_SHIFT;
+	h.nBlocks = ( h.size + LZIMAGE_BLOCK_SIZE - 1 ) >> LZIMAGE_BLOCK_SHIFT;
+
+	std::vector<u32> length( h.nBlocks, 0 );
+	std::vector<u8> data;
+	static u8 buf[ LZIMAGE_BLOCK_SIZE ];
+
+	for ( u32 i = 0; i < h.nBlocks; i++ )
+	{
+		const u8 *d = &img[ i << LZIMAGE_BLOCK_SHIFT ];
+		u32 n = std::min( (u32)LZIMAGE_BLOCK_SIZE, h.size - ( i << LZIMAGE_BLOCK_SHIFT ) );
+
+		if ( lzIsZeroBlock( d, n ) )
+			continue;
+
+		length[ i ] = lzCompressBlock( d, n, buf, n - 1 );
+		if ( length[ i ] )
+			data.insert( data.end(), buf, buf + length[ i ] ); else
+			data.insert( data.end(), d, d + ( length[ i ] = n ) );
+	}
+
+	std::vector<u8> out( (u8*)&h, (u8*)&h + sizeof( h ) );
+	out.insert( out.end(), (u8*)length.data(), (u8*)length.data() + h.nBlocks * sizeof( u32 ) );
+	out.insert( out.end(), data.begin(), data.end() );
+	return out;
+}
+
+static int decompressImage( const std::vector<u8> &z, std::vector<u8> &img )
+{
+	LZIMAGEHEADER h;
+	if ( z.size() < sizeof( h ) ) return 0;
+	memcpy( &h, z.data(), sizeof( h ) );
+
+	if ( h.magic != LZIMAGE_MAGIC || h.blockShift != LZIMAGE_BLOCK_SHIFT || h.nBlocks > LZIMAGE_MAX_BLOCKS ||
+		 h.size > ( h.nBlocks << LZIMAGE_BLOCK_SHIFT ) || z.size() < sizeof( h ) + h.nBlocks * 4 )
+		return 0;
+
+	const u32 *length = (const u32 *)&z[ sizeof( h ) ];
+	u32 pos = sizeof( h ) + h.nBlocks * 4;
+	img.assign( h.size, 0 );
+
+	for ( u32 i = 0; i < h.nBlocks; i++ )
+	{
+		u8 *d = &img[ i << LZIMAGE_BLOCK_SHIFT ];
+		u32 n = std::min( (u32)LZIMAGE_BLOCK_SIZE, h.size - ( i << LZIMAGE_BLOCK_SHIFT ) );
+
+		if ( pos + length[ i ] > z.size() )
+			return 0;
+		if ( length[ i ] == n )
+			memcpy( d, &z[ pos ], n ); else
+		if ( length[ i ] && !lzDecompressBlock( &z[ pos ], length[ i ], d, n ) )
+		{
+			printf( "corrupt block %d\n", i );
+			return 0;
+		}
+		pos += length[ i ];
+	}
+	return 1;
+}
+
+static int readAll( const char *fn, std::vector<u8> &v )
+{
+	FILE *f = fopen( fn, "rb" );
+	if ( !f ) { printf( "cannot open '%s'\n", fn ); return 0; }
+	fseek( f, 0, SEEK_END );
+	v.resize( ftell( f ) );
+	fseek( f, 0, SEEK_SET );
+	size_t r = fread( v.data(), 1, v.size(), f );
+	fclose( f );
+	return r == v.size();
+}
+
+static int writeAll( const char *fn, const std::vector<u8> &v )
+{
+	FILE *f = fopen( fn, "wb" );
+	if ( !f ) { printf( "cannot write '%s'\n", fn ); return 0; }
+	fwrite( v.data(), 1, v.size(), f );
+	fclose( f );
+	return 1;
+}
+
+static int selftest()
+{
+	// zeros, repeated patterns, text-like data, random bytes, long runs and a size which is not a multiple of the block size
+	std::vector<u8> img( 1024 * 1024 + 12345, 0 );
+	u32 x = 1;
+	for ( u32 i = 0x10000; i < 0x20000; i++ ) img[ i ] = i * 7 / 3;
+	for ( u32 i = 0x20000; i < 0x30000; i++ ) img[ i ] = "RADExp REU image "[ i % 17 ];
+	for ( u32 i = 0x30000; i < 0x50000; i++ ) { x = x * 1103515245 + 12345; img[ i ] = x >> 16; }
+	for ( u32 i = 0x50000; i < 0x58000; i++ ) img[ i ] = 0xaa;
+	for ( u32 i = 0x58000; i < 0x60000; i++ ) { x = x * 1103515245 + 12345; img[ i ] = ( x >> 16 ) & 3; }
+	for ( u32 i = 0x100000; i < img.size(); i++ ) img[ i ] = i & 0xff;
+
+	std::vector<u8> z = compressImage( img ), back;
+	if ( !decompressImage( z, back ) || back != img )
+	{
+		printf( "FAILED: round trip\n" );
+		return 1;
+	}
+
+	// the CRC-32 used for fingerprints against the bitwise reference, with unaligned starts and lengths
+	if ( ~crc32Update( 0xffffffff, (const u8 *)"123456789", 9 ) != 0xcbf43926 )
+	{
+		printf( "FAILED: crc32 check value\n" );
+		return 1;
+	}
+	for ( u32 ofs = 0; ofs < 9; ofs++ )
+		for ( u32 l = 0x2fff0; l < 0x30010; l += 5 )
+			if ( crc32Update( 0xffffffff, &img[ ofs ], l ) != crc32Bitwise( 0xffffffff, &img[ ofs ], l ) )
+			{
+				printf( "FAILED: crc32 offset %d length %d\n", ofs, l );
+				return 1;
+			}
+
+	// the loader combines the CRCs of the banks
+	u32 crcAll = ~crc32Update( 0xffffffff, img.data(), (u32)img.size() ), crc = 0;
+	for ( u32 ofs = 0, l; ofs < img.size(); ofs += l )
+	{
+		l = std::min( (u32)img.size() - ofs, 0x10000u + ofs / 3 );
+		crc = crc32Combine( crc, ~crc32Update( 0xffffffff, &img[ ofs ], l ), l );
+	}
+	std::vector<u8> zeros( 0x12345, 0 );
+	if ( crc != crcAll || crc32Zeros( (u32)zeros.size() ) != ~crc32Update( 0xffffffff, zeros.data(), (u32)zeros.size() ) )
+	{
+		printf( "FAILED: crc32 combine\n" );
+		return 1;
+	}
+
+	printf( "%d bytes -> %d bytes\n", (u32)img.size(), (u32)z.size() );
+	return 0;
+}
+
+int main( int argc, char **argv )
+{
+	if ( argc == 2 && !strcmp( argv[ 1 ], "-selftest" ) )
+		return selftest();
+
+	if ( argc == 3 && !strcmp( argv[ 1 ], "-fingerprint" ) )
+	{
+		std::vector<u8> in, img;
+		if ( !readAll( argv[ 2 ], in ) )
+			return 1;
+		if ( !decompressImage( in, img ) )
+			img = in;
+		printf( "%s: %08x\n", argv[ 2 ], ~crc32Update( 0xffffffff, img.data(), (u32)img.size() ) );
+		return 0;
+	}
+
+	int decompress = argc == 4 && !strcmp( argv[ 1 ], "-d" );
+	if ( argc != 3 && !decompress )
+	{
+		printf( "usage: reuz [-d] input output\n       reuz -fingerprint image\n       reuz -selftest\n" );
+		return 1;
+	}
+
+	std::vector<u8> in, out;
+	if ( !readAll( argv[ argc - 2 ], in ) )
+		return 1;
+
+	if ( decompress )
+	{
+		if ( !decompressImage( in, out ) )
+		{
+			printf( "'%s' is not a valid compressed image\n", argv[ argc - 2 ] );
+			return 1;
+		}
+	} else
+		out = compressImage( in );
+
+	if ( !writeAll( argv[ argc - 1 ], out ) )
+		return 1;
+
+	printf( "%s: %d bytes -> %s: %d bytes\n", argv[ argc - 2 ], (u32)in.size(), argv[ argc - 1 ], (u32)out.size() );
+	return 0;
+}
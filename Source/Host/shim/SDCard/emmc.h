@@ -0,0 +1,3 @@
+// host stand-in for Circle's <SDCard/emmc.h> (intentionally empty)
+#include <circle/types.h>
+#include <circle/logger.h>
@@ -0,0 +1,19 @@
+// host stand-in for Circle's <circle/bcm2835.h> (only the GPIO block is modelled)
+#ifndef _circle_bcm2835_h
+#define _circle_bcm2835_h
+
+#define ARM_IO_BASE			0x3F000000
+
+#define ARM_GPIO_BASE		(ARM_IO_BASE + 0x200000)
+
+#define ARM_GPIO_GPFSEL0	(ARM_GPIO_BASE + 0x00)
+#define ARM_GPIO_GPFSEL1	(ARM_GPIO_BASE + 0x04)
+#define ARM_GPIO_GPFSEL4	(ARM_GPIO_BASE + 0x10)
+#define ARM_GPIO_GPSET0		(ARM_GPIO_BASE + 0x1C)
+#define ARM_GPIO_GPCLR0		(ARM_GPIO_BASE + 0x28)
+#define ARM_GPIO_GPLEV0		(ARM_GPIO_BASE + 0x34)
+#define ARM_GPIO_GPEDS0		(ARM_GPIO_BASE + 0x40)
+#define ARM_GPIO_GPREN0		(ARM_GPIO_BASE + 0x4C)
+#define ARM_GPIO_GPFEN0		(ARM_GPIO_BASE + 0x58)
+
+#endif
@@ -0,0 +1,2 @@
+// host stand-in for Circle's <circle/interrupt.h> (intentionally empty)
+#include <circle/types.h>
@@ -0,0 +1,20 @@
+// host stand-in for Circle's <circle/memio.h>: all register accesses go to the simulated bus
+#ifndef _circle_memio_h
+#define _circle_memio_h
+
+#include <circle/types.h>
+
+extern u32 simRead32( uintptr nAddress );
+extern void simWrite32( uintptr nAddress, u32 nValue );
+
+static inline u32 read32( uintptr nAddress )
+{
+	return simRead32( nAddress );
+}
+
+static inline void write32( uintptr nAddress, u32 nValue )
+{
+	simWrite32( nAddress, nValue );
+}
+
+#endif
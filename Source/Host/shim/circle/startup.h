@@ -0,0 +1,2 @@
+// host stand-in for Circle's <circle/startup.h> (intentionally empty)
+#include <circle/types.h>
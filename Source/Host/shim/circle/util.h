@@ -0,0 +1,9 @@
+// host stand-in for Circle's <circle/util.h>
+#ifndef _circle_util_h
+#define _circle_util_h
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#endif
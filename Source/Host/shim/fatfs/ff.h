@@ -0,0 +1,2 @@
+// host stand-in for <fatfs/ff.h> (intentionally empty, the bus loops never touch the SD card)
+#include <circle/types.h>
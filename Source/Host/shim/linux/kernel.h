@@ -0,0 +1,2 @@
+// host stand-in for Circle's <linux/kernel.h>
+#include <circle/util.h>
@@ -0,0 +1,537 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - host-side bus simulator for the REU/GeoRAM polling loops
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <circle/bcm2835.h>
+#include <circle/memio.h>
+#include "gpio_defs.h"
+#include "sim_lowlevel.h"
+#include "sim_bus.h"
+
+//
+// cycle model of the expansion port as seen through the RAD's GPIOs
+//
+// - time is counted in ARM cycles and only advances when the firmware touches a GPIO register,
+//   reads the cycle counter or waits for a deadline (costs configurable in simConfig)
+// - a C64 cycle consists of a VIC half-cycle (Phi2 low) followed by a CPU half-cycle (Phi2 high)
+// - the CPU executes the scripted cycle stream, it is halted while DMA is asserted or the VIC-II owns the bus
+// - bus accesses (CPU writes, DMA writes) are committed at the falling edge of Phi2
+//
+
+SIMCONFIG simConfig = { 1400, 40, 20, 1, 0, 3, 0, 0, 20000000 };
+SIMSTATS simStats;
+
+u8 simC64RAM[ 65536 ];
+
+u8 *simExpMemory = 0;
+u32 simExpSize = 0;
+
+static SIMOP *ops;
+static SIMACTION *actions;
+static u32 nOps, curOp, idleLeft, resetLeft;
+
+static u64 simTime, counterBase;
+static u64 halfIndex, nextBoundary;
+static double armPerHalf;
+
+static u32 gpfsel[ 6 ];
+static u32 gpioOut;
+static u8  latchLo, latchHi;
+
+static u32 running, button, ba, vicOwnsBus;
+
+// CPU bus access of the current cycle
+static u32 cpuActive, cpuWrite;
+static u16 cpuAddr;
+static u8  cpuData;
+static s32 cpuExpect;
+static u32 cpuLine;
+
+// what the RAD put on the data bus during this half-cycle (the bus keeps the last value)
+static u32 radDrove;
+static u8  radData;
+
+static u32 readsThisHalf, writesThisHalf;
+
+u8 simPattern( u32 seed, u32 index )
+{
+	u32 x = ( index + 1 ) * 0x9e3779b1 + seed * 0x85ebca6b;
+	x ^= x >> 15;
+	return (u8)( x ^ ( x >> 8 ) );
+}
+
+static inline u32 isOutput( int pin )
+{
+	return ( ( gpfsel[ pin / 10 ] >> ( ( pin % 10 ) * 3 ) ) & 7 ) == 1;
+}
+
+static inline u32 outLow( int pin )
+{
+	return isOutput( pin ) && !( gpioOut & ( 1 << pin ) );
+}
+
+static inline u32 cpuHalf()			{ return halfIndex & 1; }
+static inline u32 dmaAsserted()		{ return outLow( DMA_OUT ); }
+static inline u32 addrEnabled()		{ return outLow( LATCH_A_OE ); }
+static inline u32 radWrites()		{ return outLow( RW_OUT ); }
+static inline u32 radDrivesBus()	{ return outLow( OE_Dx ) && !( gpioOut & bDIR_Dx ) && isOutput( D0 ); }
+
+static inline u8 reverse8( u8 x )
+{
+	return (u8)( simBitReverse32( x ) >> 24 );
+}
+
+static inline u16 dmaAddress()
+{
+	return ( reverse8( latchHi ) << 8 ) | reverse8( latchLo );
+}
+
+static u8 c64Read( u16 addr )
+{
+	if ( ( addr >> 8 ) == 0xde || ( addr >> 8 ) == 0xdf )
+		return 0xff;
+	return simC64RAM[ addr ];
+}
+
+static void simError( const char *msg, u32 line = 0 )
+{
+	simStats.errors ++;
+	if ( line )
+		printf( "  ERROR (half-cycle %llu, script line %d): %s\n", (unsigned long long)halfIndex, line, msg ); else
+		printf( "  ERROR (half-cycle %llu): %s\n", (unsigned long long)halfIndex, msg );
+}
+
+// value on the C64 data bus, not counting what the RAD drives itself
+static u8 busValue()
+{
+	if ( !cpuHalf() )
+		return 0xff;
+
+	if ( cpuActive && cpuWrite )
+		return cpuData;
+
+	if ( dmaAsserted() && addrEnabled() && !radWrites() )
+		return c64Read( dmaAddress() );
+
+	return 0xff;
+}
+
+static void runAction( SIMACTION *a )
+{
+	u8 *mem = a->type == SIM_ACT_FILL_C64 || a->type == SIM_ACT_CHECK_C64 ? simC64RAM : simExpMemory;
+	u32 size = a->type == SIM_ACT_FILL_C64 || a->type == SIM_ACT_CHECK_C64 ? 65536 : simExpSize;
+
+	switch ( a->type )
+	{
+	case SIM_ACT_FILL_C64:
+	case SIM_ACT_FILL_EXP:
+		for ( u32 i = 0; i < a->length; i++ )
+			mem[ ( a->addr + i ) % size ] = a->isPattern ? simPattern( a->value, i ) : a->value;
+		break;
+
+	case SIM_ACT_CHECK_C64:
+	case SIM_ACT_CHECK_EXP:
+		for ( u32 i = 0; i < a->length; i++ )
+		{
+			u8 e = a->isPattern ? simPattern( a->value, i ) : a->value;
+			u8 v = mem[ ( a->addr + i ) % size ];
+			if ( v != e )
+			{
+				printf( "  CHECK FAILED (script line %d): %s[ $%06x ] = $%02x, expected $%02x\n", a->line,
+					a->type == SIM_ACT_CHECK_C64 ? "c64" : "exp", ( a->addr + i ) % size, v, e );
+				simStats.failedChecks ++;
+				break;
+			}
+		}
+		break;
+
+	case SIM_ACT_CHECK_IRQ:
+		if ( outLow( IRQ_OUT ) != a->value )
+		{
+			printf( "  CHECK FAILED (script line %d): IRQ is %s\n", a->line, outLow( IRQ_OUT ) ? "asserted" : "released" );
+			simStats.failedChecks ++;
+		}
+		break;
+	}
+}
+
+void simRunRemainingActions()
+{
+	for ( ; curOp < nOps; curOp ++ )
+		if ( ops[ curOp ].type == SIM_OP_ACTION )
+			runAction( &actions[ ops[ curOp ].count ] );
+}
+
+// next cycle of the scripted CPU stream (zero-time entries are executed on the way)
+static void nextCPUCycle()
+{
+	cpuActive = 1; cpuWrite = 0; cpuAddr = 0x1000; cpuExpect = -1; cpuLine = 0;
+
+	if ( idleLeft )
+	{
+		idleLeft --;
+		return;
+	}
+
+	while ( curOp < nOps )
+	{
+		SIMOP *o = &ops[ curOp ++ ];
+		switch ( o->type )
+		{
+		case SIM_OP_ACTION:
+			runAction( &actions[ o->count ] );
+			break;
+		case SIM_OP_BUTTON:
+			button = 1;
+			break;
+		case SIM_OP_RESET:
+			resetLeft = o->count;
+			cpuActive = 0;
+			return;
+		case SIM_OP_IDLE:
+			if ( o->count == 0 ) break;
+			idleLeft = o->count - 1;
+			return;
+		case SIM_OP_READ:
+		case SIM_OP_WRITE:
+			cpuWrite = o->type == SIM_OP_WRITE;
+			cpuAddr = o->addr;
+			cpuData = o->data;
+			cpuExpect = o->expect;
+			cpuLine = o->line;
+			return;
+		}
+	}
+
+	// end of stream: leave the polling loop
+	button = 1;
+}
+
+static void beginHalfCycle()
+{
+	u64 c64Cycle = halfIndex >> 1;
+	u32 cyclesPerLine = simConfig.ntsc ? 65 : 63;
+	u32 linesPerFrame = simConfig.ntsc ? 263 : 312;
+	u32 cycle = c64Cycle % cyclesPerLine;
+	u32 raster = ( c64Cycle / cyclesPerLine ) % linesPerFrame;
+
+	radDrove = 0;
+	readsThisHalf = writesThisHalf = 0;
+
+	if ( !cpuHalf() )
+	{
+		// badline: BA goes low 3 cycles before the VIC-II takes over the bus for 40 cycles
+		u32 badline = simConfig.badlines && raster >= 0x30 && raster <= 0xf7 && ( raster & 7 ) == simConfig.yscroll;
+		ba = !( badline && cycle >= 11 && cycle < 54 );
+		vicOwnsBus = badline && cycle >= 14 && cycle < 54;
+		return;
+	}
+
+	cpuActive = 0;
+
+	if ( resetLeft )
+	{
+		resetLeft --;
+		return;
+	}
+
+	if ( vicOwnsBus )
+	{
+		simStats.vicStolen ++;
+		return;
+	}
+
+	if ( dmaAsserted() )
+	{
+		simStats.cpuHalted ++;
+		return;
+	}
+
+	simStats.cpuCycles ++;
+	if ( running )
+		nextCPUCycle();
+}
+
+void ( *simHalfCycleHook )() = 0;
+
+static void endHalfCycle()
+{
+	simStats.halfCycles ++;
+	if ( simHalfCycleHook ) simHalfCycleHook();
+	if ( readsThisHalf > simStats.maxGpioReadsPerHalf ) simStats.maxGpioReadsPerHalf = readsThisHalf;
+	if ( writesThisHalf > simStats.maxGpioWritesPerHalf ) simStats.maxGpioWritesPerHalf = writesThisHalf;
+
+	if ( !cpuHalf() )
+		return;
+
+	if ( radDrivesBus() )
+	{
+		radDrove = 1;
+		radData = ( gpioOut >> D0 ) & 255;
+	}
+
+	// DMA access by the RAD
+	if ( dmaAsserted() && addrEnabled() )
+	{
+		u16 a = dmaAddress();
+
+		if ( vicOwnsBus )
+			simError( "DMA access while the VIC-II owns the bus" );
+		if ( cpuActive )
+			simError( "DMA access collides with a CPU cycle" );
+
+		if ( radWrites() )
+		{
+			if ( !radDrove )
+				simError( "DMA write cycle without data on the bus" );
+			if ( ( a >> 8 ) != 0xde && ( a >> 8 ) != 0xdf )
+				simC64RAM[ a ] = radData;
+			simStats.dmaWrites ++;
+			if ( simConfig.verbose )
+				printf( "  %10llu  DMA write $%04x = $%02x\n", (unsigned long long)halfIndex, a, radData );
+		} else
+		{
+			simStats.dmaReads ++;
+			if ( simConfig.verbose )
+				printf( "  %10llu  DMA read  $%04x = $%02x\n", (unsigned long long)halfIndex, a, c64Read( a ) );
+		}
+	} else
+	if ( addrEnabled() )
+		simError( "address latch enabled without DMA" );
+
+	if ( !cpuActive )
+		return;
+
+	if ( cpuWrite )
+	{
+		if ( ( cpuAddr >> 8 ) != 0xde && ( cpuAddr >> 8 ) != 0xdf )
+			simC64RAM[ cpuAddr ] = cpuData;
+		if ( simConfig.verbose && cpuLine )
+			printf( "  %10llu  CPU write $%04x = $%02x\n", (unsigned long long)halfIndex, cpuAddr, cpuData );
+	} else
+	{
+		u8 v;
+		if ( ( cpuAddr >> 8 ) == 0xde || ( cpuAddr >> 8 ) == 0xdf )
+			v = radDrove ? radData : 0xff; else
+			v = c64Read( cpuAddr );
+
+		if ( radDrove && ( cpuAddr >> 8 ) != 0xde && ( cpuAddr >> 8 ) != 0xdf )
+			simError( "data bus driven during a CPU read outside of I/O1/I/O2", cpuLine );
+
+		if ( simConfig.verbose && cpuLine )
+			printf( "  %10llu  CPU read  $%04x = $%02x\n", (unsigned long long)halfIndex, cpuAddr, v );
+
+		if ( cpuExpect >= 0 && v != (u8)cpuExpect )
+		{
+			printf( "  CHECK FAILED (script line %d): read $%04x = $%02x, expected $%02x\n", cpuLine, cpuAddr, v, (u8)cpuExpect );
+			simStats.failedChecks ++;
+		}
+	}
+}
+
+static void advanceTo( u64 t )
+{
+	while ( t >= nextBoundary )
+	{
+		simTime = nextBoundary;
+		endHalfCycle();
+		halfIndex ++;
+		nextBoundary = (u64)( ( halfIndex + 1 ) * armPerHalf );
+		beginHalfCycle();
+
+		if ( ( halfIndex >> 1 ) > simConfig.maxC64Cycles )
+		{
+			printf( "simulation did not finish within %llu C64 cycles (polling loop stuck?)\n", (unsigned long long)simConfig.maxC64Cycles );
+			exit( 2 );
+		}
+	}
+	simTime = t;
+}
+
+// remember the value the RAD drives while it is driving (the bus keeps it after the transceiver is disabled)
+static void sampleDrive()
+{
+	if ( cpuHalf() && radDrivesBus() )
+	{
+		radDrove = 1;
+		radData = ( gpioOut >> D0 ) & 255;
+	}
+}
+
+u32 simRead32( uintptr nAddress )
+{
+	advanceTo( simTime + simConfig.gpioReadCost );
+	simStats.gpioReads ++;
+	readsThisHalf ++;
+
+	if ( nAddress >= ARM_GPIO_GPFSEL0 && nAddress < ARM_GPIO_GPFSEL0 + 6 * 4 )
+		return gpfsel[ ( nAddress - ARM_GPIO_GPFSEL0 ) / 4 ];
+
+	if ( nAddress != ARM_GPIO_GPLEV0 )
+		return 0;
+
+	u32 outMask = 0;
+	for ( int i = 0; i < 30; i++ )
+		if ( isOutput( i ) ) outMask |= 1 << i;
+
+	u32 in = ~0u;
+
+	if ( !cpuHalf() )
+		in &= ~bPHI;
+
+	if ( isOutput( MPLEX_SEL ) && ( gpioOut & bMPLEX_SEL ) )
+	{
+		// multiplexer shows A0..A7
+		u8 a = ( cpuHalf() && cpuActive ) ? ( cpuAddr & 255 ) : 0xff;
+		in &= ~( ( 15 << A0_IN ) | ( 15 << A4_IN ) );
+		in |= ( ( a & 15 ) << A0_IN ) | ( ( a >> 4 ) << A4_IN );
+	} else
+	{
+		u32 io = cpuHalf() && cpuActive;
+		if ( io && ( cpuAddr >> 8 ) == 0xde ) in &= ~bIO1;
+		if ( io && ( cpuAddr >> 8 ) == 0xdf ) in &= ~bIO2;
+		if ( io && cpuAddr >= 0xff00 ) in &= ~bTriggerFF00;
+		if ( button ) in &= ~bBUTTON;
+		if ( !ba ) in &= ~bBA;
+	}
+
+	if ( resetLeft ) in &= ~bRESET_OUT;
+	if ( cpuHalf() && cpuActive && cpuWrite ) in &= ~bRW_OUT;
+
+	// data lines: what the transceiver passes from the bus, if enabled towards the RPi
+	in &= ~D_FLAG;
+	if ( outLow( OE_Dx ) && ( gpioOut & bDIR_Dx ) )
+		in |= busValue() << D0; else
+		in |= 0xff << D0;
+
+	return ( in & ~outMask ) | ( gpioOut & outMask );
+}
+
+void simWrite32( uintptr nAddress, u32 nValue )
+{
+	advanceTo( simTime + simConfig.gpioWriteCost );
+	simStats.gpioWrites ++;
+	writesThisHalf ++;
+
+	if ( nAddress >= ARM_GPIO_GPFSEL0 && nAddress < ARM_GPIO_GPFSEL0 + 6 * 4 )
+	{
+		gpfsel[ ( nAddress - ARM_GPIO_GPFSEL0 ) / 4 ] = nValue;
+	} else
+	if ( nAddress == ARM_GPIO_GPSET0 )
+	{
+		gpioOut |= nValue;
+	} else
+	if ( nAddress == ARM_GPIO_GPCLR0 )
+	{
+		// falling edges of the latch enables capture the data lines (bit-reversed wiring)
+		u8 d = ( gpioOut >> D0 ) & 255;
+		if ( ( nValue & bLATCH_A8 ) && ( gpioOut & bLATCH_A8 ) ) latchHi = d;
+		if ( ( nValue & bLATCH_A0 ) && ( gpioOut & bLATCH_A0 ) ) latchLo = d;
+		gpioOut &= ~nValue;
+	}
+
+	// transparent latches follow the data lines
+	if ( gpioOut & bLATCH_A8 ) latchHi = ( gpioOut >> D0 ) & 255;
+	if ( gpioOut & bLATCH_A0 ) latchLo = ( gpioOut >> D0 ) & 255;
+
+	sampleDrive();
+}
+
+u64 simReadCycleCounter()
+{
+	advanceTo( simTime + simConfig.counterReadCost );
+	simStats.counterReads ++;
+	return simTime - counterBase;
+}
+
+void simResetCycleCounter()
+{
+	counterBase = simTime;
+}
+
+void simWaitUntil( u64 deadline, const char *file, int line )
+{
+	// slack is measured when the wait is entered, a late arrival still costs one counter read
+	s64 slack = (s64)deadline - (s64)( simTime - counterBase );
+
+	u32 i;
+	for ( i = 0; i < simStats.nSites; i++ )
+		if ( simStats.site[ i ].line == line && !strcmp( simStats.site[ i ].file, file ) )
+			break;
+
+	if ( i == simStats.nSites && i < SIM_MAX_SITES )
+	{
+		SIMSITE *s = &simStats.site[ simStats.nSites ++ ];
+		memset( s, 0, sizeof( SIMSITE ) );
+		s->file = file; s->line = line;
+		s->minSlack = slack; s->maxSlack = slack;
+	}
+
+	if ( i < SIM_MAX_SITES )
+	{
+		SIMSITE *s = &simStats.site[ i ];
+		s->count ++;
+		s->sumSlack += slack;
+		if ( slack < s->minSlack ) s->minSlack = slack;
+		if ( slack > s->maxSlack ) s->maxSlack = slack;
+		if ( slack < 0 ) s->late ++;
+	}
+
+	u64 now = simReadCycleCounter();
+	if ( now < deadline )
+		advanceTo( simTime + ( deadline - now ) );
+}
+
+void simInit( SIMOP *o, u32 n, SIMACTION *a )
+{
+	ops = o; nOps = n; actions = a;
+	curOp = idleLeft = resetLeft = 0;
+
+	memset( &simStats, 0, sizeof( simStats ) );
+	memset( gpfsel, 0, sizeof( gpfsel ) );
+	gpioOut = 0;
+	running = button = 0; ba = 1; vicOwnsBus = 0;
+	cpuActive = 0;
+
+	// C64 cycle at 985248 Hz (PAL) or 1022727 Hz (NTSC)
+	armPerHalf = (double)simConfig.armMHz * 1e6 / ( simConfig.ntsc ? 1022727.0 : 985248.0 ) / 2.0;
+
+	simTime = counterBase = 0;
+	halfIndex = 0;
+	nextBoundary = (u64)armPerHalf;
+	beginHalfCycle();
+}
+
+// start the scripted CPU stream (everything before, e.g. gpioInit(), runs against an idle C64)
+void simStart()
+{
+	memset( &simStats, 0, sizeof( simStats ) );
+	running = 1;
+}
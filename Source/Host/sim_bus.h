@@ -0,0 +1,116 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - host-side bus simulator for the REU/GeoRAM polling loops
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _sim_bus_h
+#define _sim_bus_h
+
+#include <circle/types.h>
+
+// one entry of the scripted 6510 bus cycle stream
+#define SIM_OP_IDLE			0		// CPU accesses RAM/ROM only (count = number of cycles)
+#define SIM_OP_READ			1		// CPU read cycle (expect = value or -1)
+#define SIM_OP_WRITE		2		// CPU write cycle
+#define SIM_OP_ACTION		3		// zero-time action (memory fill, check), executed when reached
+#define SIM_OP_BUTTON		4		// press the menu button => polling loops return
+#define SIM_OP_RESET		5		// hold /RESET low for count cycles
+
+typedef struct
+{
+	u8  type;
+	u8  data;
+	u16 addr;
+	s32 expect;
+	u32 count;
+	u32 line;
+} SIMOP;
+
+// zero-time actions
+#define SIM_ACT_FILL_C64	0
+#define SIM_ACT_FILL_EXP	1
+#define SIM_ACT_CHECK_C64	2
+#define SIM_ACT_CHECK_EXP	3
+#define SIM_ACT_CHECK_IRQ	4
+
+typedef struct
+{
+	u8  type, isPattern;
+	u32 addr, length, value;
+	u32 line;
+} SIMACTION;
+
+typedef struct
+{
+	u32 armMHz;
+	u32 gpioReadCost, gpioWriteCost, counterReadCost;
+	u32 badlines, yscroll;
+	u32 ntsc;
+	u32 verbose;
+	u64 maxC64Cycles;
+} SIMCONFIG;
+
+// deadline statistics per WAIT_UP_TO_CYCLE call site
+#define SIM_MAX_SITES		256
+
+typedef struct
+{
+	const char *file;
+	int line;
+	u64 count, late;
+	s64 sumSlack, minSlack, maxSlack;
+} SIMSITE;
+
+typedef struct
+{
+	u64 halfCycles;
+	u64 cpuCycles, cpuHalted, vicStolen;
+	u64 dmaReads, dmaWrites;
+	u64 gpioReads, gpioWrites, counterReads;
+	u32 maxGpioReadsPerHalf, maxGpioWritesPerHalf;
+	u64 errors, failedChecks;
+	u32 nSites;
+	SIMSITE site[ SIM_MAX_SITES ];
+} SIMSTATS;
+
+extern SIMCONFIG simConfig;
+extern SIMSTATS simStats;
+
+extern u8 simC64RAM[ 65536 ];
+
+// expansion memory seen by fill/check actions (REU pool or GeoRAM)
+extern u8 *simExpMemory;
+extern u32 simExpSize;
+
+// called at the end of every half-cycle, e.g. to model work done by another core in the meantime
+extern void ( *simHalfCycleHook )();
+
+extern void simInit( SIMOP *ops, u32 nOps, SIMACTION *actions );
+extern void simStart();
+extern void simRunRemainingActions();
+extern u8 simPattern( u32 seed, u32 index );
+
+#endif
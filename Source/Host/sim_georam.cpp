@@ -0,0 +1,47 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - host-side bus simulator for the REU/GeoRAM polling loops
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "rad_reu.h"
+
+// the GeoRAM polling loop lives in a header with static state, it is compiled here exactly as rad_main.cpp does
+u64 armCycleCounter;
+#include "lowlevel_dma.h"
+#include "rad_georam.h"
+
+u8 *simGeoRAMInit( u32 sizeKB )
+{
+	geoSizeKB = sizeKB;
+	geoRAM_Pool = mempoolPtr;
+	geoRAM_Init();
+	return geo.RAM;
+}
+
+void simGeoRAMRun()
+{
+	geoRAMUsingPolling();
+}
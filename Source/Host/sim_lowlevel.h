@@ -0,0 +1,94 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - host-side bus simulator for the REU/GeoRAM polling loops
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _sim_lowlevel_h
+#define _sim_lowlevel_h
+
+#include <string.h>
+#include <circle/types.h>
+
+// everything below replaces the ARM-only parts of lowlevel_arm64.h when building with RAD_HOST_SIMULATION:
+// PMCCNTR_EL0 reads return the simulated ARM cycle time, WAIT_UP_TO_CYCLE jumps ahead to the deadline
+// (and records the slack per call site), cache hints are no-ops, zeroing a cache line is a memset and barriers only stop the compiler from reordering
+extern u64 simReadCycleCounter();
+extern void simResetCycleCounter();
+extern void simWaitUntil( u64 deadline, const char *file, int line );
+
+#define BEGIN_CYCLE_COUNTER \
+								armCycleCounter = 0; \
+								armCycleCounter = simReadCycleCounter();
+
+#define RESTART_CYCLE_COUNTER \
+								armCycleCounter = simReadCycleCounter();
+
+#define READ_CYCLE_COUNTER( cc ) \
+								cc = simReadCycleCounter();
+
+#define WAIT_CYCLES( wc ) { \
+								u64 cc1 = simReadCycleCounter(); \
+								simWaitUntil( (wc) + cc1, __FILE__, __LINE__ ); }
+
+#define WAIT_UP_TO_CYCLE( wc ) { \
+								simWaitUntil( (wc) + armCycleCounter, __FILE__, __LINE__ ); }
+
+#define WAIT_UP_TO_CYCLE_AFTER( wc, cc ) { \
+								simWaitUntil( (wc) + (cc), __FILE__, __LINE__ ); }
+
+#define RESET_CPU_CYCLE_COUNTER	simResetCycleCounter();
+
+#define CACHE_PRELOADL1KEEP( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL1STRM( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL1KEEPW( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL1STRMW( ptr )	{ (void)( ptr ); }
+
+#define CACHE_PRELOADL2KEEP( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL2KEEPW( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL2STRM( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADL2STRMW( ptr )	{ (void)( ptr ); }
+#define CACHE_PRELOADI( ptr )		{ (void)( ptr ); }
+#define CACHE_PRELOADIKEEP( ptr )	{ (void)( ptr ); }
+#define CACHE_ZEROLINE( ptr )		{ memset( (void*)( ptr ), 0, 64 ); }
+
+#define MEMORY_BARRIER				{ asm volatile( "" ::: "memory" ); }
+#define DATA_SYNC_BARRIER			{ asm volatile( "" ::: "memory" ); }
+#define SIGNAL_EVENT				{ }
+#define WAIT_FOR_EVENT				{ }
+
+static inline u32 simBitReverse32( u32 x )
+{
+	x = ( ( x >> 1 ) & 0x55555555 ) | ( ( x & 0x55555555 ) << 1 );
+	x = ( ( x >> 2 ) & 0x33333333 ) | ( ( x & 0x33333333 ) << 2 );
+	x = ( ( x >> 4 ) & 0x0f0f0f0f ) | ( ( x & 0x0f0f0f0f ) << 4 );
+	x = ( ( x >> 8 ) & 0x00ff00ff ) | ( ( x & 0x00ff00ff ) << 8 );
+	return ( x >> 16 ) | ( x << 16 );
+}
+
+#define RBIT32( x )					x = simBitReverse32( x );
+#define ASM_REG( r )
+
+#endif
@@ -0,0 +1,88 @@
+/*
+
+  {_______            {_          {______
+        {__          {_ __               {__
+        {__         {_  {__               {__
+     {__           {__   {__               {__
+ {______          {__     {__              {__
+       {__       {__       {__            {__   
+         {_________         {______________		Expansion Unit
+                
+ RADExp - A framework for DMA interfacing with Commodore C64/C128 computers using a Raspberry Pi Zero 2 or 3A+/3B+
+        - reading REU transfer traces (shared by the host tools)
+ Copyright (c) 2022-2026 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _trace_file_h
+#define _trace_file_h
+
+#include <stdio.h>
+#include <vector>
+#include <circle/types.h>
+#include "reu_trace.h"
+
+// address mask of the emulated DRAM (reu.wrapAroundDRAM - 1 in the firmware)
+static inline u32 reuWrapMask( u32 reuSize )
+{
+	if ( reuSize == 0x20000 ) return 0x1ffff;
+	if ( reuSize <= 0x80000 ) return 0x7ffff;
+	return reuSize - 1;
+}
+
+// reads a trace written by reuTraceFlush() and returns the transfers in chronological order (0 on error)
+static int readREUTrace( const char *fn, REUTRACEHEADER &h, std::vector<REUTRACEENTRY> &entries )
+{
+	FILE *f = fopen( fn, "rb" );
+	if ( !f )
+	{
+		printf( "cannot open %s\n", fn );
+		return 0;
+	}
+
+	if ( fread( &h, 1, sizeof( h ), f ) != sizeof( h ) || h.magic != REU_TRACE_MAGIC || h.version != REU_TRACE_VERSION )
+	{
+		printf( "%s: not a REU trace of this version\n", fn );
+		fclose( f );
+		return 0;
+	}
+	h.title[ sizeof( h.title ) - 1 ] = 0;
+
+	u32 n = h.head < h.nEntries ? h.head : h.nEntries;
+	std::vector<REUTRACEENTRY> e( n );
+	if ( n && fread( &e[ 0 ], sizeof( REUTRACEENTRY ), n, f ) != n )
+	{
+		printf( "%s: truncated\n", fn );
+		fclose( f );
+		return 0;
+	}
+	fclose( f );
+
+	// unroll the ring buffer: once it has wrapped, the oldest entry follows the newest one
+	u32 first = 0;
+	if ( h.head > h.nEntries )
+	{
+		first = h.head & ( h.nEntries - 1 );
+		printf( "%s: ring buffer wrapped, %u oldest transfers lost\n", fn, h.head - h.nEntries );
+	}
+
+	entries.resize( n );
+	for ( u32 j = 0; j < n; j++ )
+		entries[ j ] = e[ ( first + j ) % n ];
+
+	return 1;
+}
+
+#endif